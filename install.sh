@@ -77,7 +77,6 @@ fi
 
 echo ""
 echo "Loading modules..."
-modprobe pamir-ai-soundcard || echo "Warning: Could not load pamir-ai-soundcard module"
 modprobe pamir-ai-i2c-sound || echo "Warning: Could not load pamir-ai-i2c-sound module"  
 modprobe pamir-ai-rpi-soundcard || echo "Warning: Could not load pamir-ai-rpi-soundcard module"
 
@@ -87,7 +86,6 @@ echo "1. Add 'dtoverlay=pamir-ai-soundcard' to /boot/config.txt"
 echo "2. Reboot your system"
 echo ""
 echo "Or to load modules immediately without reboot:"
-echo "  sudo modprobe pamir-ai-soundcard"
 echo "  sudo modprobe pamir-ai-i2c-sound"
 echo "  sudo modprobe pamir-ai-rpi-soundcard"
 echo ""
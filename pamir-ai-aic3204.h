@@ -0,0 +1,220 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Register map of the TLV320AIC3204 audio codec as used by the
+ * Pamir AI soundcard drivers.
+ *
+ * Copyright (C) 2025 PamirAI Incorporated - http://www.pamir.ai/
+ */
+
+#ifndef _PAMIR_AI_AIC3204_H
+#define _PAMIR_AI_AIC3204_H
+
+#include <linux/bits.h>
+
+/*
+ * The codec exposes 128 registers per page, with register 0 of every
+ * page acting as the page selector. Registers are addressed through
+ * regmap as a flat range of (page * 128 + reg) so that the regmap core
+ * only switches pages when the target page actually changes.
+ */
+#define AIC3204_PAGE_SIZE		128
+#define AIC3204_MAX_PAGE		255
+#define AIC3204_REG(page, reg)		((page) * AIC3204_PAGE_SIZE + (reg))
+#define AIC3204_REG_PAGE(reg)		((reg) / AIC3204_PAGE_SIZE)
+#define AIC3204_REG_OFFSET(reg)		((reg) % AIC3204_PAGE_SIZE)
+#define AIC3204_MAX_REGISTER		AIC3204_REG(AIC3204_MAX_PAGE, 127)
+
+/* Page 0 - clocks, interface, digital processing */
+#define AIC3204_PSEL			AIC3204_REG(0, 0x00)
+#define AIC3204_RESET			AIC3204_REG(0, 0x01)
+#define AIC3204_CLKMUX			AIC3204_REG(0, 0x04)
+#define AIC3204_PLLPR			AIC3204_REG(0, 0x05)
+#define AIC3204_PLLJ			AIC3204_REG(0, 0x06)
+#define AIC3204_PLLDMSB			AIC3204_REG(0, 0x07)
+#define AIC3204_PLLDLSB			AIC3204_REG(0, 0x08)
+#define AIC3204_NDAC			AIC3204_REG(0, 0x0b)
+#define AIC3204_MDAC			AIC3204_REG(0, 0x0c)
+#define AIC3204_DOSRMSB			AIC3204_REG(0, 0x0d)
+#define AIC3204_DOSRLSB			AIC3204_REG(0, 0x0e)
+#define AIC3204_NADC			AIC3204_REG(0, 0x12)
+#define AIC3204_MADC			AIC3204_REG(0, 0x13)
+#define AIC3204_AOSR			AIC3204_REG(0, 0x14)
+#define AIC3204_CLKOUTMUX		AIC3204_REG(0, 0x19)
+#define AIC3204_CLKOUTM			AIC3204_REG(0, 0x1a)
+#define AIC3204_IFACE1			AIC3204_REG(0, 0x1b)
+#define AIC3204_DATAOFFSET		AIC3204_REG(0, 0x1c)
+#define AIC3204_IFACE2			AIC3204_REG(0, 0x1d)
+#define AIC3204_BCLKN			AIC3204_REG(0, 0x1e)
+#define AIC3204_ADCFLAG			AIC3204_REG(0, 0x24)
+#define AIC3204_DACFLAG1		AIC3204_REG(0, 0x25)
+#define AIC3204_DACFLAG2		AIC3204_REG(0, 0x26)
+#define AIC3204_STICKYFLAG1		AIC3204_REG(0, 0x2a)
+#define AIC3204_INTFLAG1		AIC3204_REG(0, 0x2b)
+#define AIC3204_STICKYFLAG2		AIC3204_REG(0, 0x2c)
+#define AIC3204_STICKYFLAG3		AIC3204_REG(0, 0x2d)
+#define AIC3204_INTFLAG2		AIC3204_REG(0, 0x2e)
+#define AIC3204_INTFLAG3		AIC3204_REG(0, 0x2f)
+#define AIC3204_INT1CTRL		AIC3204_REG(0, 0x30)
+#define AIC3204_INT2CTRL		AIC3204_REG(0, 0x31)
+#define AIC3204_GPIOCTRL		AIC3204_REG(0, 0x34)
+#define AIC3204_DACPRB			AIC3204_REG(0, 0x3c)
+#define AIC3204_ADCPRB			AIC3204_REG(0, 0x3d)
+#define AIC3204_DACSETUP		AIC3204_REG(0, 0x3f)
+#define AIC3204_DACMUTE			AIC3204_REG(0, 0x40)
+#define AIC3204_LDACVOL			AIC3204_REG(0, 0x41)
+#define AIC3204_RDACVOL			AIC3204_REG(0, 0x42)
+#define AIC3204_HEADSETDETECT		AIC3204_REG(0, 0x43)
+#define AIC3204_ADCSETUP		AIC3204_REG(0, 0x51)
+#define AIC3204_ADCFGA			AIC3204_REG(0, 0x52)
+#define AIC3204_LADCVOL			AIC3204_REG(0, 0x53)
+#define AIC3204_RADCVOL			AIC3204_REG(0, 0x54)
+#define AIC3204_LAGCCTL1		AIC3204_REG(0, 0x56)
+#define AIC3204_LAGCCTL2		AIC3204_REG(0, 0x57)
+#define AIC3204_LAGCMAXGAIN		AIC3204_REG(0, 0x58)
+#define AIC3204_LAGCATTACK		AIC3204_REG(0, 0x59)
+#define AIC3204_LAGCDECAY		AIC3204_REG(0, 0x5a)
+#define AIC3204_LAGCNOISEDEB		AIC3204_REG(0, 0x5b)
+#define AIC3204_LAGCSIGDEB		AIC3204_REG(0, 0x5c)
+#define AIC3204_LAGCGAIN		AIC3204_REG(0, 0x5d)
+#define AIC3204_RAGCCTL1		AIC3204_REG(0, 0x5e)
+#define AIC3204_RAGCCTL2		AIC3204_REG(0, 0x5f)
+#define AIC3204_RAGCMAXGAIN		AIC3204_REG(0, 0x60)
+#define AIC3204_RAGCATTACK		AIC3204_REG(0, 0x61)
+#define AIC3204_RAGCDECAY		AIC3204_REG(0, 0x62)
+#define AIC3204_RAGCNOISEDEB		AIC3204_REG(0, 0x63)
+#define AIC3204_RAGCSIGDEB		AIC3204_REG(0, 0x64)
+#define AIC3204_RAGCGAIN		AIC3204_REG(0, 0x65)
+
+/* Page 1 - analog power, routing and gain */
+#define AIC3204_PWRCFG			AIC3204_REG(1, 0x01)
+#define AIC3204_LDOCTL			AIC3204_REG(1, 0x02)
+#define AIC3204_OUTPWRCTL		AIC3204_REG(1, 0x09)
+#define AIC3204_HPLROUTE		AIC3204_REG(1, 0x0c)
+#define AIC3204_HPRROUTE		AIC3204_REG(1, 0x0d)
+#define AIC3204_LOLROUTE		AIC3204_REG(1, 0x0e)
+#define AIC3204_LORROUTE		AIC3204_REG(1, 0x0f)
+#define AIC3204_HPLGAIN			AIC3204_REG(1, 0x10)
+#define AIC3204_HPRGAIN			AIC3204_REG(1, 0x11)
+#define AIC3204_LOLGAIN			AIC3204_REG(1, 0x12)
+#define AIC3204_LORGAIN			AIC3204_REG(1, 0x13)
+#define AIC3204_HPSTART			AIC3204_REG(1, 0x14)
+#define AIC3204_MICBIAS			AIC3204_REG(1, 0x33)
+#define AIC3204_LMICPGAPIN		AIC3204_REG(1, 0x34)
+#define AIC3204_LMICPGANIN		AIC3204_REG(1, 0x36)
+#define AIC3204_RMICPGAPIN		AIC3204_REG(1, 0x37)
+#define AIC3204_RMICPGANIN		AIC3204_REG(1, 0x39)
+#define AIC3204_LMICPGAVOL		AIC3204_REG(1, 0x3b)
+#define AIC3204_RMICPGAVOL		AIC3204_REG(1, 0x3c)
+#define AIC3204_ADCGAINFLAG		AIC3204_REG(1, 0x3e)
+#define AIC3204_DACGAINFLAG		AIC3204_REG(1, 0x3f)
+#define AIC3204_REFPOWERUP		AIC3204_REG(1, 0x7b)
+
+/* Pages 8 and up hold the miniDSP / biquad coefficient RAM */
+#define AIC3204_COEF_PAGE_MIN		8
+
+/*
+ * Coefficient buffers A and B of the ADC and DAC processing blocks, nine
+ * pages each with the coefficients in registers 8-127. Register 1 of the
+ * first buffer A page controls adaptive filtering for the path.
+ */
+#define AIC3204_ADC_COEF_A_PAGE		8
+#define AIC3204_ADC_COEF_B_PAGE		26
+#define AIC3204_DAC_COEF_A_PAGE		44
+#define AIC3204_DAC_COEF_B_PAGE		62
+#define AIC3204_COEF_PAGES		9
+#define AIC3204_COEF_REG_MIN		8
+#define AIC3204_COEF_LEN		(AIC3204_PAGE_SIZE - AIC3204_COEF_REG_MIN)
+#define AIC3204_ADC_ADAPTIVE		AIC3204_REG(AIC3204_ADC_COEF_A_PAGE, 0x01)
+#define AIC3204_DAC_ADAPTIVE		AIC3204_REG(AIC3204_DAC_COEF_A_PAGE, 0x01)
+
+/* Clock setting register 1, multiplexers (Page 0, 0x04) */
+#define AIC3204_PLL_CLKIN_MASK		GENMASK(3, 2)
+#define AIC3204_PLL_CLKIN_MCLK		(0 << 2)
+#define AIC3204_PLL_CLKIN_BCLK		(1 << 2)
+#define AIC3204_CODEC_CLKIN_MASK	GENMASK(1, 0)
+#define AIC3204_CODEC_CLKIN_MCLK	0x00
+#define AIC3204_CODEC_CLKIN_BCLK	0x01
+#define AIC3204_CODEC_CLKIN_PLL		0x03
+
+/* Clock setting register 2, PLL P and R values (Page 0, 0x05) */
+#define AIC3204_PLL_POWER		BIT(7)
+
+/* Clock divider registers (NDAC, MDAC, NADC, MADC, BCLKN) */
+#define AIC3204_DIV_POWER		BIT(7)
+#define AIC3204_DIV_MASK		GENMASK(6, 0)
+
+/* Audio interface setting register 1 (Page 0, 0x1b) */
+#define AIC3204_IFACE1_MODE_MASK	GENMASK(7, 6)
+#define AIC3204_IFACE1_I2S		(0 << 6)
+#define AIC3204_IFACE1_DSP		(1 << 6)
+#define AIC3204_IFACE1_RJF		(2 << 6)
+#define AIC3204_IFACE1_LJF		(3 << 6)
+#define AIC3204_WORD_LEN_MASK		GENMASK(5, 4)
+#define AIC3204_WORD_LEN_16		(0 << 4)
+#define AIC3204_WORD_LEN_20		(1 << 4)
+#define AIC3204_WORD_LEN_24		(2 << 4)
+#define AIC3204_WORD_LEN_32		(3 << 4)
+#define AIC3204_IFACE1_BCLK_OUT		BIT(3)
+#define AIC3204_IFACE1_WCLK_OUT		BIT(2)
+#define AIC3204_IFACE1_DOUT_HIZ		BIT(0)
+
+/* Audio interface setting register 2 (Page 0, 0x1d) */
+#define AIC3204_DIN_DOUT_LOOPBACK_SHIFT	5	/* DIN copied to DOUT */
+#define AIC3204_BCLK_INV		BIT(3)
+#define AIC3204_BDIV_CLKIN_MASK		GENMASK(1, 0)
+#define AIC3204_BDIV_CLKIN_DAC_CLK	0x00
+#define AIC3204_BDIV_CLKIN_DAC_MOD_CLK	0x01
+
+/* DAC channel setup (Page 0, 0x3f) soft-stepping control */
+#define AIC3204_DAC_SOFTSTEP_MASK	GENMASK(1, 0)
+#define AIC3204_DAC_SOFTSTEP_1		0x00	/* one step per sample */
+#define AIC3204_DAC_SOFTSTEP_2		0x01	/* one step per two samples */
+#define AIC3204_DAC_SOFTSTEP_OFF	0x02
+
+/* Adaptive filter configuration (Page 8 and 44, 0x01) */
+#define AIC3204_ADAPTIVE_ENABLE		BIT(2)
+#define AIC3204_ADAPTIVE_BUF_B		BIT(1)	/* codec is using buffer B */
+#define AIC3204_ADAPTIVE_SWITCH		BIT(0)	/* self-clearing */
+
+/* AGC control registers (Page 0, 0x56-0x64) */
+#define AIC3204_AGC_ENABLE		BIT(7)
+#define AIC3204_AGC_TARGET_SHIFT	4
+#define AIC3204_AGC_NOISE_SHIFT		1
+#define AIC3204_AGC_TIME_SHIFT		3
+#define AIC3204_AGC_MAX_GAIN		116	/* 58 dB in 0.5 dB steps */
+#define AIC3204_AGC_MIN_APPLIED		-24	/* -12 dB in 0.5 dB steps */
+
+/* DAC flag register 1 (Page 0, 0x25), output driver power status */
+#define AIC3204_DACFLAG_LOL		BIT(6)
+#define AIC3204_DACFLAG_HPL		BIT(5)
+#define AIC3204_DACFLAG_LOR		BIT(2)
+#define AIC3204_DACFLAG_HPR		BIT(1)
+
+/* Sticky flag register 2 (Page 0, 0x2c), cleared on read */
+#define AIC3204_FLAG_BUTTON		BIT(5)
+#define AIC3204_FLAG_HEADSET		BIT(4)
+
+/* INT1 interrupt control (Page 0, 0x30) */
+#define AIC3204_INT_HEADSET		BIT(7)
+#define AIC3204_INT_BUTTON		BIT(6)
+
+/* Headset detection configuration (Page 0, 0x43) */
+#define AIC3204_HSDET_ENABLE		BIT(7)
+#define AIC3204_HSDET_STATUS_MASK	GENMASK(6, 5)
+#define AIC3204_HSDET_NONE		(0 << 5)
+#define AIC3204_HSDET_HEADPHONE		(1 << 5)
+#define AIC3204_HSDET_HEADSET		(3 << 5)
+#define AIC3204_HSDET_DEBOUNCE_128MS	(3 << 2)
+
+/* Reference power-up configuration (Page 1, 0x7b) */
+#define AIC3204_REF_CHARGE_MASK		GENMASK(1, 0)
+#define AIC3204_REF_CHARGE_SOFT		0x00
+#define AIC3204_REF_CHARGE_40MS		0x01
+#define AIC3204_REF_CHARGE_80MS		0x02
+#define AIC3204_REF_CHARGE_120MS	0x03
+
+/* Output driver gain registers (Page 1, 0x10-0x13) */
+#define AIC3204_DRV_MUTE		BIT(6)
+#define AIC3204_DRV_GAIN_MASK		GENMASK(5, 0)
+
+#endif /* _PAMIR_AI_AIC3204_H */
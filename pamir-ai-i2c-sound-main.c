@@ -1,7 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0
 /*
- * Driver for configuring the TLV320AIC3204 audio codec via
- * I2C register writes.
+ * ASoC codec driver for the TLV320AIC3204 audio codec on the
+ * Pamir AI soundcard, controlled via I2C register writes.
  *
  * Copyright (C) 2025 PamirAI Incorporated - http://www.pamir.ai/
  *	Utsav Balar <utsavbalar1231@gmail.com
@@ -9,223 +9,719 @@
 
 /**
  * TODOs:
- * - Add support for parsing defaults from device tree
- * - Use latest kernel APIs for I2C communication and sysfs
- * - Use register names from the datasheet instead of magic numbers
+ * - Use latest kernel APIs for sysfs
  */
 
+#include <kunit/visibility.h>
+#include <linux/clk.h>
+#include <linux/completion.h>
+#include <linux/debugfs.h>
+#include <linux/delay.h>
+#include <linux/firmware.h>
+#include <linux/gpio/consumer.h>
 #include <linux/i2c.h>
+#include <linux/interrupt.h>
+#include <linux/jiffies.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
+#include <linux/pm_runtime.h>
+#include <linux/property.h>
 #include <linux/device.h>
+#include <linux/regmap.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
 #include <linux/sysfs.h>
+#include <linux/workqueue.h>
+#include <sound/jack.h>
+#include <sound/pcm.h>
+#include <sound/pcm_params.h>
+#include <sound/soc.h>
+#include <sound/soc-dai.h>
+#include <sound/soc-dapm.h>
+#include <sound/tlv.h>
+
+#include "pamir-ai-aic3204.h"
+#include "pamir-ai-i2c-sound.h"
+
+#define CREATE_TRACE_POINTS
+#include "pamir-ai-trace.h"
+
+#define PAMIR_AI_RAMP_MAX_MS	10000
+/* MCLK rate assumed when no "mclk" clock is given in the device tree */
+#define PAMIR_AI_DEFAULT_MCLK_HZ	12288000
+#define PAMIR_AI_AUTOSUSPEND_MS		3000
+/* PLL lock time after power-up */
+#define PAMIR_AI_PLL_LOCK_US		10000
+/* Wait after releasing the reset line before the first register access */
+#define PAMIR_AI_RESET_US		1000
+/* Longest wait for an output driver to report powered up, per default */
+#define PAMIR_AI_SETTLE_TIMEOUT_MS	500
+
+/* Slots per frame accepted in TDM mode, the codec uses two of them */
+#define PAMIR_AI_MAX_TDM_SLOTS		8
 
-/**
- * struct reg_val - register value pair
- * @reg: register address
- * @val: register value
+/*
+ * Processing blocks and their group delay in 1/fs. PRB_P1/PRB_R1 with
+ * decimation/interpolation filter A are the post-reset defaults,
+ * PRB_P17 (filter C, DOSR 32) and PRB_R7 (filter B, AOSR 64) trade
+ * stopband attenuation for a shorter delay.
  */
-struct reg_val {
-	u8 reg;
-	u8 val;
-};
-
-/**
- * struct pamir_ai_i2c_sound_data - private data for pamir AI sound
- * @client: I2C client
- * @dev: device structure
- * @volume: volume level (0-100)
- * @input_gain: input gain level (0-100)
+#define PAMIR_AI_DAC_PRB		1
+#define PAMIR_AI_DAC_DELAY		21
+#define PAMIR_AI_DAC_PRB_LL		17
+#define PAMIR_AI_DAC_DOSR_LL		32
+#define PAMIR_AI_DAC_DELAY_LL		13
+/* Lowest DAC_MOD_CLK (DOSR * fs) the interpolation filters accept */
+#define PAMIR_AI_DAC_MOD_CLK_MIN	2800000
+#define PAMIR_AI_ADC_PRB		1
+#define PAMIR_AI_ADC_DELAY		17
+#define PAMIR_AI_ADC_PRB_LL		7
+#define PAMIR_AI_ADC_AOSR_LL		64
+#define PAMIR_AI_ADC_DELAY_LL		11
+/*
+ * Instruction budget of the processing blocks: MDAC * DOSR / 32 and
+ * MADC * AOSR / 32 must reach these resource classes of PRB_P1 and
+ * PRB_R1. Low latency mode keeps both products unchanged.
  */
-struct pamir_ai_i2c_sound_data {
-	struct i2c_client *client;
-	struct device *dev;
-	u8 volume;
-	u8 input_gain;
-};
+#define PAMIR_AI_DAC_RC			8
+#define PAMIR_AI_ADC_RC			6
+
+/* Retries of a register access failing with a transient bus error */
+#define PAMIR_AI_I2C_RETRIES		3
+/* Wait before the first retry, doubled for each further one */
+#define PAMIR_AI_I2C_BACKOFF_US		1000
 
 /**
  * Initialization sequence for the AIC3204 device,
+ * page selection is handled by the regmap range configuration.
+ *
+ * Runs of consecutive registers are flushed as a single auto-increment
+ * block write, so keep related registers adjacent. The HP/LO driver,
+ * DAC and ADC volume registers are left to set_volume/set_input_gain.
  */
-static const struct reg_val init_sequence[] = {
-	/* Software reset and page selection */
-	{ 0x00, 0x00 }, /* Select Page 0 */
-	{ 0x01, 0x01 }, /* Initialize device through software reset */
+static const struct reg_sequence init_sequence[] = {
+	/* Software reset - Page 0 */
+	{ AIC3204_RESET, 0x01 }, /* Initialize device through software reset */
 	/* Clock configuration - Page 0 */
-	{ 0x00, 0x00 }, /* Select Page 0 */
-	{ 0x0b, 0x81 }, /* NDAC = 1, dividers powered on */
-	{ 0x0c, 0x84 }, /* MDAC = 2, dividers powered on */
-	{ 0x12, 0x81 }, /* NADC = 1, dividers powered on (1000 0001) */
-	{ 0x13, 0x84 }, /* MADC = 4, dividers powered on (1000 0100) */
+	{ AIC3204_NDAC, 0x81 }, /* NDAC = 1, dividers powered on */
+	{ AIC3204_MDAC, 0x84 }, /* MDAC = 2, dividers powered on */
+	{ AIC3204_NADC, 0x81 }, /* NADC = 1, dividers powered on (1000 0001) */
+	{ AIC3204_MADC, 0x84 }, /* MADC = 4, dividers powered on (1000 0100) */
 	/* GPIO and clock output configuration */
-	{ 0x19, 0x07 }, /* CDIV_CLKIN = ADC_MOD_CLK (0111) */
-	{ 0x1a, 0x81 }, /* Divider = 1 and power up, CLKOUT = CDIV_CLKIN / 1 (3MHz) */
-	{ 0x34, 0x10 }, /* Set GPIO output */
+	{ AIC3204_CLKOUTMUX, 0x07 }, /* CDIV_CLKIN = ADC_MOD_CLK (0111) */
+	{ AIC3204_CLKOUTM, 0x81 }, /* Divider = 1 and power up, CLKOUT = CDIV_CLKIN / 1 (3MHz) */
+	{ AIC3204_GPIOCTRL, 0x10 }, /* GPIO/MFP5 drives INT1 */
 	/* Power management - Page 1 */
-	{ 0x00, 0x01 }, /* Select Page 1 */
-	{ 0x02, 0x09 }, /* Power up AVDD LDO */
-	{ 0x01, 0x08 }, /* Disable weak AVDD in presence of external AVDD supply */
-	{ 0x02, 0x01 }, /* Enable Master Analog Power Control, Power up AVDD LDO */
-	{ 0x21, 0x00 }, /* MICBIAS off */
-	{ 0x7b, 0x01 }, /* Set REF charging time to 40ms */
+	{ AIC3204_LDOCTL, 0x08 }, /* AVDD LDO and analog blocks off, powered by DAPM */
+	{ AIC3204_PWRCFG, 0x08 }, /* Disable weak AVDD in presence of external AVDD supply */
+	{ AIC3204_REFPOWERUP, 0x01 }, /* REF charging time 40ms, see pamir-ai,ref-charge-ms */
 	/* Audio routing and output configuration - Page 1 */
-	{ 0x00, 0x01 }, /* Select Page 1 */
-	{ 0x14, 0x25 }, /* De-pop: 5 time constants, 6k resistance */
-	{ 0x0c, 0x08 }, /* Route LDAC to HPL */
-	{ 0x0d, 0x08 }, /* Route RDAC to HPR */
-	{ 0x0e, 0x08 }, /* Route LDAC to LOL */
-	{ 0x0f, 0x08 }, /* Route RDAC to LOR */
-	{ 0x09, 0x3c }, /* Power up HPL/HPR (modified to configure LOL) */
-	{ 0x10, 0x07 }, /* Unmute HPL, 29dB gain (00 011101) */
-	{ 0x11, 0x07 }, /* Unmute HPR, 29dB gain */
-	{ 0x12, 0x07 }, /* Unmute LOL, 29dB gain */
-	{ 0x13, 0x07 }, /* Unmute LOR, 29dB gain */
+	{ AIC3204_HPSTART, 0x25 }, /* De-pop: 5 time constants, 6k resistance */
+	{ AIC3204_HPLROUTE, 0x08 }, /* Route LDAC to HPL */
+	{ AIC3204_HPRROUTE, 0x08 }, /* Route RDAC to HPR */
+	{ AIC3204_LOLROUTE, 0x08 }, /* Route LDAC to LOL */
+	{ AIC3204_LORROUTE, 0x08 }, /* Route RDAC to LOR */
 	/* ADC configuration - Page 1 */
-	{ 0x00, 0x01 }, /* Select Page 1 */
-	{ 0x34, 0x80 }, /* ADC configuration */
-	{ 0x36, 0x80 }, /* ADC configuration */
-	{ 0x37, 0x80 }, /* ADC configuration */
-	{ 0x39, 0x80 }, /* ADC configuration */
-	{ 0x3b, 0x0f }, /* PGA configuration */
-	{ 0x3c, 0x0f }, /* Right PGA + 47dB */
-	/* DAC and ADC initialization - Page 0 */
-	{ 0x00, 0x00 }, /* Select Page 0 */
-	{ 0x51, 0xc0 }, /* Change ADC channel and power (11000000) */
-	{ 0x52, 0x00 }, /* Unmute ADC */
-	/* Volume and gain settings - Page 0 */
-	{ 0x00, 0x00 }, /* Select Page 0 */
-	{ 0x53, 0x23 }, /* Set ADC left volume +20dB */
-	{ 0x54, 0x23 }, /* Set ADC right volume +20dB */
-	{ 0x41, 0x30 }, /* Set DAC left with +24dB */
-	{ 0x42, 0x30 }, /* Set DAC right with +24dB */
-	/* Final DAC configuration - Page 0 */
-	{ 0x00, 0x00 }, /* Select Page 0 */
-	{ 0x41, 0x00 }, /* DAC left => 0dB (overrides previous +24dB setting) */
-	{ 0x42, 0x00 }, /* DAC right => 0dB (overrides previous +24dB setting) */
-	{ 0x3f, 0xd6 }, /* Power up LDAC/RDAC */
-	{ 0x40, 0x00 }, /* Unmute LDAC/RDAC */
+	{ AIC3204_LMICPGAPIN, 0x80 }, /* ADC configuration */
+	{ AIC3204_LMICPGANIN, 0x80 }, /* ADC configuration */
+	{ AIC3204_RMICPGAPIN, 0x80 }, /* ADC configuration */
+	{ AIC3204_RMICPGANIN, 0x80 }, /* ADC configuration */
+	{ AIC3204_LMICPGAVOL, 0x0f }, /* PGA configuration */
+	{ AIC3204_RMICPGAVOL, 0x0f }, /* Right PGA + 47dB */
+	/* Final DAC configuration - Page 0; DAC, ADC and driver power follow DAPM */
+	{ AIC3204_DACSETUP, 0x14 }, /* LDAC/RDAC data paths, soft-step 1 per sample */
+	{ AIC3204_DACMUTE, 0x00 }, /* Unmute LDAC/RDAC */
+	/* AGC off; the reset value of the max gain is out of range */
+	{ AIC3204_LAGCMAXGAIN, 0x50 }, /* Left AGC max gain 40 dB */
+	{ AIC3204_RAGCMAXGAIN, 0x50 }, /* Right AGC max gain 40 dB */
+};
+
+/*
+ * Only the page 0 range needs to be described, every page shares the
+ * same selector register at offset 0 of the window.
+ */
+static const struct regmap_range_cfg pamir_ai_i2c_sound_regmap_pages[] = {
+	{
+		.name = "pages",
+		.range_min = 0,
+		.range_max = AIC3204_MAX_REGISTER,
+		.selector_reg = AIC3204_PSEL,
+		.selector_mask = 0xff,
+		.selector_shift = 0,
+		.window_start = 0,
+		.window_len = AIC3204_PAGE_SIZE,
+	},
 };
 
 /**
- * pamir_ai_i2c_sound_set_volume - set the volume of the AIC3204 device
+ * pamir_ai_i2c_sound_volatile_reg - registers that must bypass the cache
+ * @dev: device structure
+ * @reg: flat (page * 128 + offset) register address
+ *
+ * Status flags, the headset detection status, the AGC applied gain
+ * readback and the self-clearing reset bit are updated by the codec
+ * itself. The coefficient RAM pages are
+ * swapped by the codec in adaptive filtering mode, so they are never
+ * cached either.
+ *
+ * Return: true if the register must always be read from the device
+ */
+static bool pamir_ai_i2c_sound_volatile_reg(struct device *dev,
+					     unsigned int reg)
+{
+	switch (reg) {
+	case AIC3204_RESET:
+	case AIC3204_ADCFLAG:
+	case AIC3204_DACFLAG1:
+	case AIC3204_DACFLAG2:
+	case AIC3204_STICKYFLAG1 ... AIC3204_INTFLAG3:
+	case AIC3204_HEADSETDETECT:
+	case AIC3204_LAGCGAIN:
+	case AIC3204_RAGCGAIN:
+	case AIC3204_ADCGAINFLAG:
+	case AIC3204_DACGAINFLAG:
+		return true;
+	}
+
+	return AIC3204_REG_PAGE(reg) >= AIC3204_COEF_PAGE_MIN;
+}
+
+/* Sticky flags, cleared by reading them, see pamir_ai_i2c_sound_irq() */
+static bool pamir_ai_i2c_sound_clear_on_read(unsigned int reg)
+{
+	switch (reg) {
+	case AIC3204_STICKYFLAG1:
+	case AIC3204_STICKYFLAG2:
+	case AIC3204_STICKYFLAG3:
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Power-on reset values of the registers the driver programs. With these
+ * in place regcache_sync() after a reset only rewrites registers whose
+ * cached value differs from the hardware default. Registers missing from
+ * the table are always rewritten.
+ */
+static const struct reg_default pamir_ai_i2c_sound_reg_defaults[] = {
+	{ AIC3204_CLKMUX, 0x00 },
+	{ AIC3204_PLLPR, 0x11 },
+	{ AIC3204_PLLJ, 0x04 },
+	{ AIC3204_PLLDMSB, 0x00 },
+	{ AIC3204_PLLDLSB, 0x00 },
+	{ AIC3204_NDAC, 0x01 },
+	{ AIC3204_MDAC, 0x01 },
+	{ AIC3204_DOSRMSB, 0x00 },
+	{ AIC3204_DOSRLSB, 0x80 },
+	{ AIC3204_NADC, 0x01 },
+	{ AIC3204_MADC, 0x01 },
+	{ AIC3204_AOSR, 0x80 },
+	{ AIC3204_CLKOUTMUX, 0x00 },
+	{ AIC3204_CLKOUTM, 0x01 },
+	{ AIC3204_IFACE1, 0x00 },
+	{ AIC3204_DATAOFFSET, 0x00 },
+	{ AIC3204_IFACE2, 0x00 },
+	{ AIC3204_BCLKN, 0x01 },
+	{ AIC3204_INT1CTRL, 0x00 },
+	{ AIC3204_DACPRB, 0x01 },
+	{ AIC3204_ADCPRB, 0x01 },
+	{ AIC3204_DACSETUP, 0x14 },
+	{ AIC3204_DACMUTE, 0x0c },
+	{ AIC3204_LDACVOL, 0x00 },
+	{ AIC3204_RDACVOL, 0x00 },
+	{ AIC3204_ADCSETUP, 0x00 },
+	{ AIC3204_ADCFGA, 0x88 },
+	{ AIC3204_LADCVOL, 0x00 },
+	{ AIC3204_RADCVOL, 0x00 },
+	{ AIC3204_LAGCCTL1, 0x00 },
+	{ AIC3204_LAGCCTL2, 0x00 },
+	{ AIC3204_LAGCMAXGAIN, 0x7f },
+	{ AIC3204_LAGCATTACK, 0x00 },
+	{ AIC3204_LAGCDECAY, 0x00 },
+	{ AIC3204_LAGCNOISEDEB, 0x00 },
+	{ AIC3204_LAGCSIGDEB, 0x00 },
+	{ AIC3204_RAGCCTL1, 0x00 },
+	{ AIC3204_RAGCCTL2, 0x00 },
+	{ AIC3204_RAGCMAXGAIN, 0x7f },
+	{ AIC3204_RAGCATTACK, 0x00 },
+	{ AIC3204_RAGCDECAY, 0x00 },
+	{ AIC3204_RAGCNOISEDEB, 0x00 },
+	{ AIC3204_RAGCSIGDEB, 0x00 },
+	{ AIC3204_OUTPWRCTL, 0x00 },
+	{ AIC3204_HPLROUTE, 0x00 },
+	{ AIC3204_HPRROUTE, 0x00 },
+	{ AIC3204_LOLROUTE, 0x00 },
+	{ AIC3204_LORROUTE, 0x00 },
+	{ AIC3204_HPLGAIN, 0x40 },
+	{ AIC3204_HPRGAIN, 0x40 },
+	{ AIC3204_LOLGAIN, 0x40 },
+	{ AIC3204_LORGAIN, 0x40 },
+	{ AIC3204_MICBIAS, 0x00 },
+	{ AIC3204_LMICPGAPIN, 0x00 },
+	{ AIC3204_LMICPGANIN, 0x00 },
+	{ AIC3204_RMICPGAPIN, 0x00 },
+	{ AIC3204_RMICPGANIN, 0x00 },
+	{ AIC3204_LMICPGAVOL, 0x80 },
+	{ AIC3204_RMICPGAVOL, 0x80 },
+};
+
+/*
+ * Locking is left to the regmap core: its per-map mutex covers the page
+ * select together with the access that follows, so single register and
+ * block accesses from sysfs, ALSA controls and DAPM never land on
+ * another user's page. Sequences spanning several accesses take
+ * @level_lock or @dsp_lock on top.
+ */
+VISIBLE_IF_KUNIT const struct regmap_config
+pamir_ai_i2c_sound_regmap_config = {
+	.reg_bits = 8,
+	.val_bits = 8,
+	.max_register = AIC3204_MAX_REGISTER,
+	.ranges = pamir_ai_i2c_sound_regmap_pages,
+	.num_ranges = ARRAY_SIZE(pamir_ai_i2c_sound_regmap_pages),
+	.volatile_reg = pamir_ai_i2c_sound_volatile_reg,
+	.reg_defaults = pamir_ai_i2c_sound_reg_defaults,
+	.num_reg_defaults = ARRAY_SIZE(pamir_ai_i2c_sound_reg_defaults),
+	.cache_type = REGCACHE_MAPLE,
+};
+EXPORT_SYMBOL_IF_KUNIT(pamir_ai_i2c_sound_regmap_config);
+
+/* Transient bus errors worth another attempt, see pamir_ai_i2c_account */
+static bool pamir_ai_i2c_transient(int ret)
+{
+	return ret == -EAGAIN || ret == -EREMOTEIO || ret == -ETIMEDOUT;
+}
+
+/**
+ * pamir_ai_i2c_account - record one register access and decide on a retry
  * @data: private data structure
- * @volume: volume level (0-100)
+ * @op: operation the access belongs to
+ * @start: time the access was started
+ * @ret: result of the access
+ * @attempt: retries done so far for this access, incremented on retry
  *
- * This function sets the volume of the AIC3204 device by writing to
- * the appropriate registers.
+ * Transient bus errors (arbitration loss, NAK, timeout) are retried up
+ * to PAMIR_AI_I2C_RETRIES times, waiting PAMIR_AI_I2C_BACKOFF_US before
+ * the first retry and twice as long before each further one. Every
+ * attempt that reaches the bus counts as a transaction.
  *
- * Return: 0 on success, negative error code on failure
+ * Return: true if the access should be issued again
  */
-static int pamir_ai_i2c_sound_set_volume(struct pamir_ai_i2c_sound_data *data,
-				     u8 volume)
+static bool pamir_ai_i2c_account(struct pamir_ai_i2c_sound_data *data,
+				 enum pamir_ai_i2c_op op, ktime_t start,
+				 int ret, unsigned int *attempt)
 {
+	struct pamir_ai_i2c_stats *stats = &data->stats[op];
+	s64 us = ktime_us_delta(ktime_get(), start);
+	unsigned int bucket;
+	bool retry;
+
+	bucket = us > 0 ? min_t(unsigned int, fls64(us),
+				PAMIR_AI_LAT_BUCKETS - 1) : 0;
+	retry = pamir_ai_i2c_transient(ret) &&
+		*attempt < PAMIR_AI_I2C_RETRIES;
+
+	spin_lock(&data->stats_lock);
+	stats->transactions++;
+	/* Address and data NAKs, see Documentation/i2c/fault-codes.rst */
+	if (ret == -ENXIO || ret == -EREMOTEIO)
+		stats->naks++;
+	else if (ret < 0)
+		stats->errors++;
+	if (retry)
+		stats->retries++;
+	stats->hist[bucket]++;
+	spin_unlock(&data->stats_lock);
+
+	if (retry)
+		fsleep(PAMIR_AI_I2C_BACKOFF_US << (*attempt)++);
+
+	return retry;
+}
+
+/* Whether reading @count registers from @reg is served by the cache */
+static bool pamir_ai_i2c_cached(struct pamir_ai_i2c_sound_data *data,
+				unsigned int reg, size_t count)
+{
+	for (; count; reg++, count--)
+		if (pamir_ai_i2c_sound_volatile_reg(data->dev, reg) ||
+		    !regcache_reg_cached(data->regmap, reg))
+			return false;
+
+	return true;
+}
+
+/*
+ * Register accessors used by the driver's own operations. They behave
+ * like their regmap counterparts, retry transient bus errors and
+ * account each attempt to @op. Reads served from the register cache
+ * never reach the bus and are not accounted.
+ */
+static int pamir_ai_i2c_read(struct pamir_ai_i2c_sound_data *data,
+			     enum pamir_ai_i2c_op op, unsigned int reg,
+			     unsigned int *val)
+{
+	unsigned int attempt = 0;
+	ktime_t start;
 	int ret;
-	u8 hp_val, dac_val;
 
-	if (volume > 100)
-		volume = 100;
-	else if (volume < 0)
-		volume = 0;
+	if (pamir_ai_i2c_cached(data, reg, 1))
+		return regmap_read(data->regmap, reg, val);
 
-	data->volume = volume;
+	do {
+		start = ktime_get();
+		ret = regmap_read(data->regmap, reg, val);
+	} while (pamir_ai_i2c_account(data, op, start, ret, &attempt));
 
-	/*
-	 * DAC Volume Control (Page 0, Registers 0x41/0x42):
-	 * 0x00 = 0dB (no attenuation)
-	 * 0xFF to 0x81 = -0.5dB to -63.5dB
-	 * 0x01 to 0x30 = +0.5dB to +24dB
-	 *
-	 * Headphone/Line Driver Gain (Page 1, Registers 0x10-0x13):
-	 * Bit D6 = Mute bit (1=mute, 0=unmute)
-	 * Bits D5-D0 = Gain value:
-	 *   0x00 = 0dB
-	 *   0x1D = +29dB (maximum)
-	 *   0x3A = -6dB (minimum, can't be muted in this setting)
-	 */
+	return ret;
+}
 
-	if (volume == 0) {
-		/* Mute all outputs by setting mute bit */
-		hp_val = 0x40; /* Set mute bit (D6) */
-		dac_val = 0x00; /* Use 0dB for DAC (no effect when muted) */
-	} else {
-		/* Two-stage volume control strategy:
-		 * 1. For 1-100: Keep DAC at 0dB for clean signal, adjust HP gain
-		 * 2. Fine-tune perceived volume curve using both when needed
-		 */
+static int pamir_ai_i2c_bulk_read(struct pamir_ai_i2c_sound_data *data,
+				  enum pamir_ai_i2c_op op, unsigned int reg,
+				  void *val, size_t len)
+{
+	unsigned int attempt = 0;
+	ktime_t start;
+	int ret;
+
+	if (pamir_ai_i2c_cached(data, reg, len))
+		return regmap_bulk_read(data->regmap, reg, val, len);
+
+	do {
+		start = ktime_get();
+		ret = regmap_bulk_read(data->regmap, reg, val, len);
+	} while (pamir_ai_i2c_account(data, op, start, ret, &attempt));
+
+	return ret;
+}
+
+static int pamir_ai_i2c_write(struct pamir_ai_i2c_sound_data *data,
+			      enum pamir_ai_i2c_op op, unsigned int reg,
+			      unsigned int val)
+{
+	unsigned int attempt = 0;
+	ktime_t start;
+	int ret;
+
+	do {
+		start = ktime_get();
+		ret = regmap_write(data->regmap, reg, val);
+		trace_pamir_ai_reg_write(data->client, reg, val, 1,
+					 ktime_to_ns(ktime_sub(ktime_get(),
+							       start)));
+	} while (pamir_ai_i2c_account(data, op, start, ret, &attempt));
+
+	return ret;
+}
+
+static int pamir_ai_i2c_bulk_write(struct pamir_ai_i2c_sound_data *data,
+				   enum pamir_ai_i2c_op op, unsigned int reg,
+				   const u8 *val, size_t len)
+{
+	unsigned int attempt = 0;
+	ktime_t start;
+	int ret;
+
+	do {
+		start = ktime_get();
+		ret = regmap_bulk_write(data->regmap, reg, val, len);
+		trace_pamir_ai_reg_write(data->client, reg, val[0], len,
+					 ktime_to_ns(ktime_sub(ktime_get(),
+							       start)));
+	} while (pamir_ai_i2c_account(data, op, start, ret, &attempt));
+
+	return ret;
+}
+
+static int pamir_ai_i2c_update_bits(struct pamir_ai_i2c_sound_data *data,
+				    enum pamir_ai_i2c_op op, unsigned int reg,
+				    unsigned int mask, unsigned int val)
+{
+	unsigned int attempt = 0;
+	bool changed;
+	ktime_t start;
+	int ret;
 
-		/* Unmute by clearing mute bit (D6) */
-		hp_val = 0x00;
-
-		if (volume <= 20) {
-			/* Low volume (1-20): Use -6dB to 0dB for HP + some DAC attenuation */
-			hp_val |= 0x3A - ((volume - 1) * (0x3A - 0x00) / 19);
-			dac_val = 0xA0; /* Around -32dB attenuation */
-		} else if (volume <= 60) {
-			/* Medium volume (21-60): Use 0dB to +20dB for HP, no DAC attenuation */
-			hp_val |= ((volume - 21) * 0x14) /
-				  39; /* Map to 0x00-0x14 (0dB to +20dB) */
-			dac_val = 0x00; /* 0dB (no attenuation) */
-		} else {
-			/* High volume (61-100): Use +20dB to +29dB for HP, some DAC boost */
-			hp_val |= 0x14 +
-				  ((volume - 61) * (0x1D - 0x14)) /
-					  39; /* 0x14-0x1D (+20dB to +29dB) */
-
-			/* For very high volumes, add some DAC boost */
-			if (volume > 90) {
-				/* Add a bit of DAC boost for the highest volumes (91-100) */
-				dac_val = 0x04 +
-					  ((volume - 91) * (0x10 - 0x04)) /
-						  9; /* +2dB to +8dB boost */
-			} else {
-				dac_val = 0x00; /* 0dB (no boost/attenuation) */
-			}
+	do {
+		start = ktime_get();
+		ret = regmap_update_bits_check(data->regmap, reg, mask, val,
+					       &changed);
+		/* A cached register already holding @val is left alone */
+		if (!ret && !changed && pamir_ai_i2c_cached(data, reg, 1))
+			return 0;
+		trace_pamir_ai_reg_write(data->client, reg, val, 1,
+					 ktime_to_ns(ktime_sub(ktime_get(),
+							       start)));
+	} while (pamir_ai_i2c_account(data, op, start, ret, &attempt));
+
+	return ret;
+}
+
+/**
+ * pamir_ai_i2c_sound_write_sequence - flush a register sequence to the codec
+ * @data: private data structure
+ * @seq: register sequence
+ * @num: number of entries in @seq
+ *
+ * Consecutive registers on the same page are grouped into a single
+ * auto-increment block write, everything else is written one register
+ * at a time. A non-zero delay_us ends the current block and is honoured
+ * before the next write.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+VISIBLE_IF_KUNIT int
+pamir_ai_i2c_sound_write_sequence(struct pamir_ai_i2c_sound_data *data,
+				  const struct reg_sequence *seq, int num)
+{
+	u8 block[AIC3204_PAGE_SIZE];
+	unsigned int reg;
+	int i, len, ret;
+
+	for (i = 0; i < num; i += len) {
+		reg = seq[i].reg;
+		len = 0;
+		do {
+			block[len] = seq[i + len].def;
+			len++;
+		} while (i + len < num && !seq[i + len - 1].delay_us &&
+			 seq[i + len].reg == reg + len &&
+			 AIC3204_REG_OFFSET(reg) + len < AIC3204_PAGE_SIZE);
+
+		if (len == 1)
+			ret = pamir_ai_i2c_write(data, PAMIR_AI_OP_INIT, reg,
+						 block[0]);
+		else
+			ret = pamir_ai_i2c_bulk_write(data, PAMIR_AI_OP_INIT,
+						      reg, block, len);
+		if (ret < 0) {
+			dev_err(data->dev,
+				"Failed to write %d register(s) at page %d reg 0x%02x: %d\n",
+				len, AIC3204_REG_PAGE(reg),
+				AIC3204_REG_OFFSET(reg), ret);
+			return ret;
 		}
+
+		if (seq[i + len - 1].delay_us)
+			fsleep(seq[i + len - 1].delay_us);
 	}
 
-	/* Set page 1 for headphone/line out gain */
-	ret = i2c_smbus_write_byte_data(data->client, 0x00, 0x01);
-	if (ret < 0)
-		return ret;
+	return 0;
+}
+EXPORT_SYMBOL_IF_KUNIT(pamir_ai_i2c_sound_write_sequence);
 
-	/* Set headphone gains (left and right) */
-	ret = i2c_smbus_write_byte_data(data->client, 0x10, hp_val);
-	if (ret < 0)
-		return ret;
+/**
+ * pamir_ai_i2c_sound_init_codec - write the built-in init sequence
+ * @data: private data structure
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+VISIBLE_IF_KUNIT int
+pamir_ai_i2c_sound_init_codec(struct pamir_ai_i2c_sound_data *data)
+{
+	return pamir_ai_i2c_sound_write_sequence(data, init_sequence,
+						 ARRAY_SIZE(init_sequence));
+}
+EXPORT_SYMBOL_IF_KUNIT(pamir_ai_i2c_sound_init_codec);
 
-	ret = i2c_smbus_write_byte_data(data->client, 0x11, hp_val);
-	if (ret < 0)
-		return ret;
+/*
+ * DAC Volume Control (Page 0, Registers 0x41/0x42):
+ * 0x00 = 0dB (no attenuation)
+ * 0xFF to 0x81 = -0.5dB to -63.5dB
+ * 0x01 to 0x30 = +0.5dB to +24dB
+ *
+ * Headphone/Line Driver Gain (Page 1, Registers 0x10-0x13):
+ * Bit D6 = Mute bit (1=mute, 0=unmute)
+ * Bits D5-D0 = Gain value (6-bit two's complement):
+ *   0x00 = 0dB
+ *   0x1D = +29dB (maximum)
+ *   0x3A = -6dB (minimum, can't be muted in this setting)
+ *
+ * The driver gain is fixed per band and the DAC, in 0.5dB steps,
+ * provides the fine control:
+ *   1-20:   HP 0dB,   DAC -31.5dB to -3dB   (1.5dB per step)
+ *   21-60:  HP +17dB, DAC -19.5dB to 0dB    (0.5dB per step)
+ *   61-100: HP +29dB, DAC -11.5dB to +8dB   (0.5dB per step)
+ * Every level maps to a distinct register pair.
+ */
+#define PAMIR_AI_VOL_BAND(v) \
+	((v) == 0 ? 0 : (v) <= 20 ? 1 : (v) <= 60 ? 2 : 3)
+#define PAMIR_AI_VOL_HP(v) \
+	((v) == 0 ? AIC3204_DRV_MUTE : (v) <= 20 ? 0x00 : (v) <= 60 ? 0x11 : 0x1d)
+#define PAMIR_AI_VOL_DAC(v) \
+	((u8)((v) == 0 ? 0 : (v) <= 20 ? 3 * (v) - 66 : \
+	      (v) <= 60 ? (v) - 60 : (v) - 84))
 
-	/* Set line out gains (left and right) */
-	ret = i2c_smbus_write_byte_data(data->client, 0x12, hp_val);
-	if (ret < 0)
-		return ret;
+/*
+ * ADC Volume Control (Page 0, Registers 0x53/0x54):
+ * 7-bit two's complement in 0.5dB steps, -12dB (0x68) to +20dB (0x28)
+ *
+ * ADC Fine Gain (Page 0, Register 0x52, D6-D4 left, D2-D0 right):
+ * 0 to -0.4dB in 0.1dB steps
+ *
+ * Map 0-100 scale to ADC gain, in 0.1dB units:
+ * - 0-19: -12dB to -0.6dB (0.6dB per step)
+ * - 20-100: 0dB to +20dB (0.25dB per step)
+ * The coarse volume is rounded up and the fine gain takes off the rest,
+ * so every level maps to a distinct register pair.
+ */
+#define PAMIR_AI_GAIN_TENTHS(g) \
+	((g) < 20 ? -120 + 6 * (g) : 5 * ((g) - 20) / 2)
+#define PAMIR_AI_GAIN_COARSE(g) \
+	(PAMIR_AI_GAIN_TENTHS(g) >= 0 ? (PAMIR_AI_GAIN_TENTHS(g) + 4) / 5 : \
+					PAMIR_AI_GAIN_TENTHS(g) / 5)
+#define PAMIR_AI_GAIN_ADC(g)	((u8)(PAMIR_AI_GAIN_COARSE(g) & 0x7f))
+#define PAMIR_AI_GAIN_FINE(g) \
+	((u8)(5 * PAMIR_AI_GAIN_COARSE(g) - PAMIR_AI_GAIN_TENTHS(g)))
+
+/* Expand m(n) for every level from 0 to 100 */
+#define PAMIR_AI_LEVELS_10(m, n) \
+	m(n), m(n + 1), m(n + 2), m(n + 3), m(n + 4), \
+	m(n + 5), m(n + 6), m(n + 7), m(n + 8), m(n + 9)
+#define PAMIR_AI_LEVELS(m) \
+	PAMIR_AI_LEVELS_10(m, 0), PAMIR_AI_LEVELS_10(m, 10), \
+	PAMIR_AI_LEVELS_10(m, 20), PAMIR_AI_LEVELS_10(m, 30), \
+	PAMIR_AI_LEVELS_10(m, 40), PAMIR_AI_LEVELS_10(m, 50), \
+	PAMIR_AI_LEVELS_10(m, 60), PAMIR_AI_LEVELS_10(m, 70), \
+	PAMIR_AI_LEVELS_10(m, 80), PAMIR_AI_LEVELS_10(m, 90), m(100)
 
-	ret = i2c_smbus_write_byte_data(data->client, 0x13, hp_val);
-	if (ret < 0)
-		return ret;
+/**
+ * struct pamir_ai_volume_regs - register values for one volume level
+ * @hp_val: HP/LO driver gain
+ * @dac_val: DAC digital volume
+ */
+struct pamir_ai_volume_regs {
+	u8 hp_val;
+	u8 dac_val;
+};
+
+/**
+ * struct pamir_ai_gain_regs - register values for one input gain level
+ * @adc_val: ADC coarse volume
+ * @fine_val: ADC fine gain, left and right
+ */
+struct pamir_ai_gain_regs {
+	u8 adc_val;
+	u8 fine_val;
+};
+
+#define PAMIR_AI_VOL_ENTRY(v) \
+	{ .hp_val = PAMIR_AI_VOL_HP(v), .dac_val = PAMIR_AI_VOL_DAC(v) }
+#define PAMIR_AI_GAIN_ENTRY(g) \
+	{ .adc_val = PAMIR_AI_GAIN_ADC(g), \
+	  .fine_val = PAMIR_AI_GAIN_FINE(g) << 4 | PAMIR_AI_GAIN_FINE(g) }
+
+/* Reverse indexes hold the level plus one, zero marks an off-curve value */
+#define PAMIR_AI_VOL_INDEX(v) \
+	[PAMIR_AI_VOL_BAND(v)][PAMIR_AI_VOL_DAC(v)] = (v) + 1
+#define PAMIR_AI_GAIN_INDEX(g) \
+	[PAMIR_AI_GAIN_ADC(g)][PAMIR_AI_GAIN_FINE(g)] = (g) + 1
+
+static const struct pamir_ai_volume_regs pamir_ai_volume_table[101] = {
+	PAMIR_AI_LEVELS(PAMIR_AI_VOL_ENTRY)
+};
+
+static const struct pamir_ai_gain_regs pamir_ai_gain_table[101] = {
+	PAMIR_AI_LEVELS(PAMIR_AI_GAIN_ENTRY)
+};
+
+/* Keyed by volume band and DAC volume register value */
+static const u8 pamir_ai_volume_index[4][256] = {
+	PAMIR_AI_LEVELS(PAMIR_AI_VOL_INDEX)
+};
+
+/* Keyed by ADC coarse volume and fine gain register values */
+static const u8 pamir_ai_gain_index[128][8] = {
+	PAMIR_AI_LEVELS(PAMIR_AI_GAIN_INDEX)
+};
+
+/* Lowest and highest volume level of each band */
+static const u8 pamir_ai_volume_band_edges[][2] = {
+	{ 0, 0 },
+	{ 1, 20 },
+	{ 21, 60 },
+	{ 61, 100 },
+};
+
+/**
+ * pamir_ai_i2c_sound_set_volume - set the volume of the AIC3204 device
+ * @data: private data structure
+ * @volume: volume level (0-100)
+ *
+ * This function sets the volume of the AIC3204 device by writing to
+ * the appropriate registers. The DAC volume is soft-stepped by the
+ * codec, the HP/LO driver gains are only written when the band changes.
+ * When the driver gain goes down (or mutes) it is written before the
+ * DAC and after it otherwise, so a band crossing dips rather than
+ * overshoots.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+VISIBLE_IF_KUNIT int
+pamir_ai_i2c_sound_set_volume(struct pamir_ai_i2c_sound_data *data, u8 volume)
+{
+	u8 drv_gain[4], dac_vol[2];
+	unsigned int old_hp_val;
+	u8 hp_val, dac_val;
+	bool write_hp;
+	int ret;
 
-	/* Set page 0 for DAC volume */
-	ret = i2c_smbus_write_byte_data(data->client, 0x00, 0x00);
+	if (volume > 100)
+		volume = 100;
+
+	hp_val = pamir_ai_volume_table[volume].hp_val;
+	dac_val = pamir_ai_volume_table[volume].dac_val;
+
+	/* Served from the register cache once the gain has been written */
+	ret = pamir_ai_i2c_read(data, PAMIR_AI_OP_VOLUME_SET, AIC3204_HPLGAIN,
+				&old_hp_val);
 	if (ret < 0)
 		return ret;
 
+	write_hp = old_hp_val != hp_val;
+	memset(drv_gain, hp_val, sizeof(drv_gain));
+	dac_vol[0] = dac_val;
+	dac_vol[1] = dac_val;
+
+	/* Set headphone and line out gains (HPL, HPR, LOL, LOR) in one block */
+	if (write_hp && (hp_val & AIC3204_DRV_MUTE ||
+	    (!(old_hp_val & AIC3204_DRV_MUTE) &&
+	     sign_extend32(hp_val, 5) < sign_extend32(old_hp_val, 5)))) {
+		ret = pamir_ai_i2c_bulk_write(data, PAMIR_AI_OP_VOLUME_SET,
+					      AIC3204_HPLGAIN, drv_gain,
+					      ARRAY_SIZE(drv_gain));
+		if (ret < 0)
+			return ret;
+		write_hp = false;
+	}
+
 	/* Set DAC volumes (left and right) */
-	ret = i2c_smbus_write_byte_data(data->client, 0x41, dac_val);
+	ret = pamir_ai_i2c_bulk_write(data, PAMIR_AI_OP_VOLUME_SET,
+				      AIC3204_LDACVOL, dac_vol,
+				      ARRAY_SIZE(dac_vol));
 	if (ret < 0)
 		return ret;
 
-	ret = i2c_smbus_write_byte_data(data->client, 0x42, dac_val);
-	if (ret < 0)
-		return ret;
+	if (write_hp) {
+		ret = pamir_ai_i2c_bulk_write(data, PAMIR_AI_OP_VOLUME_SET,
+					      AIC3204_HPLGAIN, drv_gain,
+					      ARRAY_SIZE(drv_gain));
+		if (ret < 0)
+			return ret;
+	}
+
+	data->volume = volume;
 
-	dev_info(data->dev,
-		 "Volume set to %d%% (hp_val=0x%02x, dac_val=0x%02x)\n", volume,
-		 hp_val, dac_val);
+	trace_pamir_ai_volume(data->client, volume, hp_val, dac_val);
 
 	return 0;
 }
+EXPORT_SYMBOL_IF_KUNIT(pamir_ai_i2c_sound_set_volume);
 
 /**
  * pamir_ai_i2c_sound_set_input_gain - set the input gain of the AIC3204 device
@@ -237,59 +733,32 @@ static int pamir_ai_i2c_sound_set_volume(struct pamir_ai_i2c_sound_data *data,
  *
  * Return: 0 on success, negative error code on failure
  */
-static int pamir_ai_i2c_sound_set_input_gain(struct pamir_ai_i2c_sound_data *data,
-					 u8 gain)
+VISIBLE_IF_KUNIT int
+pamir_ai_i2c_sound_set_input_gain(struct pamir_ai_i2c_sound_data *data, u8 gain)
 {
+	u8 adc_vol[3];
 	int ret;
-	u8 adc_val;
 
 	if (gain > 100)
 		gain = 100;
-	else if (gain < 0)
-		gain = 0;
-
-	data->input_gain = gain;
-
-	/*
-	 * ADC Volume Control (Page 0, Registers 0x53/0x54):
-	 * Range: -12dB (0x68) to +20dB (0x28)
-	 * 0x00 represents 0dB
-	 *
-	 * Map 0-100 scale to ADC gain:
-	 * - 0-19: -12dB to just below 0dB (0x68 to 0x29)
-	 * - 20-100: 0dB to +20dB (0x00 to 0x28)
-	 * Note: Ranges designed to avoid overlap for unambiguous readback
-	 */
-
-	if (gain < 20) {
-		/* Low gain (0-19): -12dB to just below 0dB */
-		/* Map to 0x68 down to 0x29 (avoiding overlap with positive range) */
-		adc_val = 0x68 - ((gain * (0x68 - 0x29)) / 19);
-	} else {
-		/* Higher gain (20-100): 0dB to +20dB */
-		/* Map to 0x00 up to 0x28 */
-		adc_val = ((gain - 20) * 0x28) / 80;
-	}
-
-	/* Set page 0 for ADC volume */
-	ret = i2c_smbus_write_byte_data(data->client, 0x00, 0x00);
-	if (ret < 0)
-		return ret;
 
-	/* Set ADC volumes (left and right) */
-	ret = i2c_smbus_write_byte_data(data->client, 0x53, adc_val);
+	/* Set ADC fine gain and volumes (left and right) in one block */
+	adc_vol[0] = pamir_ai_gain_table[gain].fine_val;
+	adc_vol[1] = pamir_ai_gain_table[gain].adc_val;
+	adc_vol[2] = pamir_ai_gain_table[gain].adc_val;
+	ret = pamir_ai_i2c_bulk_write(data, PAMIR_AI_OP_GAIN_SET,
+				      AIC3204_ADCFGA, adc_vol,
+				      ARRAY_SIZE(adc_vol));
 	if (ret < 0)
 		return ret;
 
-	ret = i2c_smbus_write_byte_data(data->client, 0x54, adc_val);
-	if (ret < 0)
-		return ret;
+	data->input_gain = gain;
 
-	dev_info(data->dev, "Input gain set to %d%% (adc_val=0x%02x)\n", gain,
-		 adc_val);
+	trace_pamir_ai_input_gain(data->client, gain, adc_vol[1], adc_vol[0]);
 
 	return 0;
 }
+EXPORT_SYMBOL_IF_KUNIT(pamir_ai_i2c_sound_set_input_gain);
 
 /**
  * pamir_ai_i2c_sound_get_volume - get the current volume of the AIC3204 device
@@ -300,97 +769,50 @@ static int pamir_ai_i2c_sound_set_input_gain(struct pamir_ai_i2c_sound_data *dat
  *
  * Return: 0 on success, negative error code on failure
  */
-static int pamir_ai_i2c_sound_get_volume(struct pamir_ai_i2c_sound_data *data)
+VISIBLE_IF_KUNIT int
+pamir_ai_i2c_sound_get_volume(struct pamir_ai_i2c_sound_data *data)
 {
+	unsigned int hp_val, dac_val;
+	u8 volume;
 	int ret;
-	u8 hp_val, dac_val;
-	u8 volume = 0;
-	bool is_muted = false;
 
 	/* Read headphone gain from page 1 reg 0x10 (left headphone volume) */
-	ret = i2c_smbus_write_byte_data(data->client, 0x00, 0x01);
-	if (ret < 0)
-		return ret;
-
-	ret = i2c_smbus_read_byte_data(data->client, 0x10);
+	ret = pamir_ai_i2c_read(data, PAMIR_AI_OP_VOLUME_GET, AIC3204_HPLGAIN,
+				&hp_val);
 	if (ret < 0)
 		return ret;
 
-	hp_val = ret;
-
-	/* Check mute bit (D6) */
-	if (hp_val & 0x40)
-		is_muted = true;
-
-	/* Get gain bits (D5-D0) */
-	hp_val &= 0x3F;
-
 	/* Read DAC gain from page 0 reg 0x41 (left DAC volume) */
-	ret = i2c_smbus_write_byte_data(data->client, 0x00, 0x00);
-	if (ret < 0)
-		return ret;
-
-	ret = i2c_smbus_read_byte_data(data->client, 0x41);
+	ret = pamir_ai_i2c_read(data, PAMIR_AI_OP_VOLUME_GET, AIC3204_LDACVOL,
+				&dac_val);
 	if (ret < 0)
 		return ret;
 
-	dac_val = ret;
-
-	/* If muted, volume is 0 */
-	if (is_muted) {
+	switch (hp_val) {
+	case PAMIR_AI_VOL_HP(0):
+		volume = pamir_ai_volume_index[0][dac_val];
+		break;
+	case PAMIR_AI_VOL_HP(1):
+		volume = pamir_ai_volume_index[1][dac_val];
+		break;
+	case PAMIR_AI_VOL_HP(21):
+		volume = pamir_ai_volume_index[2][dac_val];
+		break;
+	case PAMIR_AI_VOL_HP(61):
+		volume = pamir_ai_volume_index[3][dac_val];
+		break;
+	default:
 		volume = 0;
-	} else {
-		/* Reverse the mapping logic from set_volume */
-
-		/* Check if we're in the high volume range with DAC boost */
-		if (dac_val >= 0x04 && dac_val <= 0x10) {
-			/* High volume range (91-100) with DAC boost */
-			volume = 91 + ((dac_val - 0x04) * 9) / (0x10 - 0x04);
-		}
-		/* Check if we're in the high volume range (hp gain between +20dB and +29dB) */
-		else if (hp_val >= 0x14 && hp_val <= 0x1D) {
-			/* High volume range (61-90) */
-			volume = 61 + ((hp_val - 0x14) * 39) / (0x1D - 0x14);
-			if (volume > 90)
-				volume =
-					90; /* Cap at 90 if no DAC boost detected */
-		}
-		/* Check if we're in the medium volume range (hp gain between 0dB and +20dB) */
-		else if (hp_val <= 0x14 && dac_val == 0x00) {
-			/* Medium volume range (21-60) */
-			volume = 21 + (hp_val * 39) / 0x14;
-		}
-		/* Check if we're in the low volume range (hp gain between -6dB and 0dB) */
-		else if (hp_val >= 0x00 && hp_val <= 0x3A && dac_val == 0xA0) {
-			/* Low volume range (1-20) */
-			volume = 1 + ((0x3A - hp_val) * 19) / (0x3A - 0x00);
-		}
-		/* Fallback if the registers are in an unexpected state */
-		else {
-			/* Try to make a best guess based on HP gain */
-			if (hp_val <= 0x00) {
-				volume = 21; /* 0dB = ~21% volume */
-			} else if (hp_val <= 0x14) {
-				volume = 21 + (hp_val * 39) /
-						      0x14; /* 0dB to +20dB */
-			} else if (hp_val <= 0x1D) {
-				volume = 61 +
-					 ((hp_val - 0x14) * 39) /
-						 (0x1D -
-						  0x14); /* +20dB to +29dB */
-			} else {
-				volume =
-					20; /* Default to 20% if in attenuation range */
-			}
-		}
+		break;
 	}
 
-	if (volume > 100)
-		volume = 100;
-	data->volume = volume;
+	/* Registers programmed outside of the driver may fall off the curve */
+	if (volume)
+		data->volume = volume - 1;
 
 	return 0;
 }
+EXPORT_SYMBOL_IF_KUNIT(pamir_ai_i2c_sound_get_volume);
 
 /**
  * pamir_ai_i2c_sound_get_input_gain - get the current input gain of the AIC3204 device
@@ -401,50 +823,44 @@ static int pamir_ai_i2c_sound_get_volume(struct pamir_ai_i2c_sound_data *data)
  *
  * Return: 0 on success, negative error code on failure
  */
-static int pamir_ai_i2c_sound_get_input_gain(struct pamir_ai_i2c_sound_data *data)
+VISIBLE_IF_KUNIT int
+pamir_ai_i2c_sound_get_input_gain(struct pamir_ai_i2c_sound_data *data)
 {
-	int ret;
-	u8 adc_val;
+	unsigned int fine_val, adc_val;
 	u8 gain;
+	int ret;
 
-	/* Set page 0 for ADC volume */
-	ret = i2c_smbus_write_byte_data(data->client, 0x00, 0x00);
+	/* Read ADC fine gain from register 0x52 (left in D6-D4) */
+	ret = pamir_ai_i2c_read(data, PAMIR_AI_OP_GAIN_GET, AIC3204_ADCFGA,
+				&fine_val);
 	if (ret < 0)
 		return ret;
 
 	/* Read ADC gain from register 0x53 (left ADC volume) */
-	ret = i2c_smbus_read_byte_data(data->client, 0x53);
+	ret = pamir_ai_i2c_read(data, PAMIR_AI_OP_GAIN_GET, AIC3204_LADCVOL,
+				&adc_val);
 	if (ret < 0)
 		return ret;
 
-	adc_val = ret & 0x7F; /* Mask out the reserved bit */
-
-	/* Convert the ADC value to gain percentage */
-	if (adc_val >= 0x68) {
-		/* Minimum gain (-12dB or below) */
-		gain = 0;
-	} else if (adc_val <= 0x28) {
-		/* 0dB to +20dB (0x00 to 0x28) maps to 20-100% */
-		gain = 20 + ((adc_val * 80) / 0x28);
-	} else {
-		/* -12dB to just below 0dB (0x29 to 0x67) maps to 1-19% */
-		gain = ((0x68 - adc_val) * 19) / (0x68 - 0x29);
-	}
+	/* Mask out the reserved and mute bits */
+	gain = pamir_ai_gain_index[adc_val & 0x7f][(fine_val >> 4) & 0x07];
 
-	/* Store the read input gain value */
-	data->input_gain = gain;
+	/* Registers programmed outside of the driver may fall off the curve */
+	if (gain)
+		data->input_gain = gain - 1;
 
 	return 0;
 }
+EXPORT_SYMBOL_IF_KUNIT(pamir_ai_i2c_sound_get_input_gain);
 
 /**
- * register_access_show - read a register from the codec
+ * register_access_show - read the selected codec register
  * @dev: device structure
  * @attr: device attribute
  * @buf: buffer to write the register value to
  *
- * This function allows userspace to read a register from the codec.
- * The format is "page reg" (e.g., "0 53" to read page 0 register 0x53).
+ * Reads the register last selected by writing "page reg" (or written
+ * with "page reg value") to register_access.
  *
  * Return: number of bytes written to buffer, or negative error code
  */
@@ -452,47 +868,37 @@ static ssize_t register_access_show(struct device *dev,
 				   struct device_attribute *attr, char *buf)
 {
 	struct pamir_ai_i2c_sound_data *data = dev_get_drvdata(dev);
-	int page, reg, value;
+	unsigned int reg = READ_ONCE(data->access_reg);
+	unsigned int value;
 	int ret;
 
-	/* Get last page and reg from the previous write */
-	if (sscanf(buf, "%d %d", &page, &reg) != 2) {
-		dev_err(dev, "Invalid format. Use: 'page reg'\n");
-		return -EINVAL;
-	}
-
-	if (page < 0 || page > 255 || reg < 0 || reg > 255) {
-		dev_err(dev, "Invalid page or register value (0-255)\n");
-		return -EINVAL;
-	}
+	ret = pm_runtime_resume_and_get(dev);
+	if (ret < 0)
+		return ret;
 
-	/* First select the page */
-	ret = i2c_smbus_write_byte_data(data->client, 0x00, page);
+	ret = pamir_ai_i2c_read(data, PAMIR_AI_OP_REG_ACCESS, reg, &value);
+	pm_runtime_mark_last_busy(dev);
+	pm_runtime_put_autosuspend(dev);
 	if (ret < 0) {
-		dev_err(dev, "Failed to select page %d: %d\n", page, ret);
+		dev_err(dev, "Failed to read page %u reg 0x%02x: %d\n",
+			AIC3204_REG_PAGE(reg), AIC3204_REG_OFFSET(reg), ret);
 		return ret;
 	}
 
-	/* Then read the register */
-	value = i2c_smbus_read_byte_data(data->client, reg);
-	if (value < 0) {
-		dev_err(dev, "Failed to read register 0x%02x: %d\n", reg, value);
-		return value;
-	}
-
-	dev_info(dev, "Read page %d reg 0x%02x: 0x%02x\n", page, reg, value);
-	return sprintf(buf, "%d\n", value);
+	return sprintf(buf, "%u\n", value);
 }
 
 /**
- * register_access_store - write to a register of the codec
+ * register_access_store - select or write a register of the codec
  * @dev: device structure
  * @attr: device attribute
- * @buf: buffer containing the register and value to write
+ * @buf: buffer containing the register and optional value to write
  * @count: number of bytes in the buffer
  *
- * This function allows userspace to write to a register of the codec.
- * The format is "page reg value" (e.g., "0 41 0" to write 0 to page 0 register 0x41).
+ * "page reg" selects the register returned by register_access_show,
+ * "page reg value" additionally writes @value to it (e.g., "0 65 0" to
+ * write 0 to page 0 register 0x41). Register 0 is the page selector and
+ * is managed by the regmap core.
  *
  * Return: number of bytes processed, or negative error code
  */
@@ -502,71 +908,327 @@ static ssize_t register_access_store(struct device *dev,
 {
 	struct pamir_ai_i2c_sound_data *data = dev_get_drvdata(dev);
 	int page, reg, value;
-	int ret;
+	int num, ret;
 
-	if (sscanf(buf, "%d %d %d", &page, &reg, &value) != 3) {
-		dev_err(dev, "Invalid format. Use: 'page reg value'\n");
+	num = sscanf(buf, "%d %d %d", &page, &reg, &value);
+	if (num < 2) {
+		dev_err(dev, "Invalid format. Use: 'page reg [value]'\n");
 		return -EINVAL;
 	}
 
-	if (page < 0 || page > 255 || reg < 0 || reg > 255 || value < 0 || value > 255) {
-		dev_err(dev, "Invalid parameter(s), valid range is 0-255\n");
+	if (page < 0 || page > AIC3204_MAX_PAGE || reg < 1 ||
+	    reg >= AIC3204_PAGE_SIZE ||
+	    (num == 3 && (value < 0 || value > 255))) {
+		dev_err(dev, "Invalid parameter(s), valid range is 0-255 (register 1-127)\n");
 		return -EINVAL;
 	}
 
-	/* First select the page */
-	ret = i2c_smbus_write_byte_data(data->client, 0x00, page);
-	if (ret < 0) {
-		dev_err(dev, "Failed to select page %d: %d\n", page, ret);
+	WRITE_ONCE(data->access_reg, AIC3204_REG(page, reg));
+	if (num == 2)
+		return count;
+
+	ret = pm_runtime_resume_and_get(dev);
+	if (ret < 0)
 		return ret;
-	}
 
-	/* Then write to the register */
-	ret = i2c_smbus_write_byte_data(data->client, reg, value);
+	ret = pamir_ai_i2c_write(data, PAMIR_AI_OP_REG_ACCESS,
+				 AIC3204_REG(page, reg), value);
+	pm_runtime_mark_last_busy(dev);
+	pm_runtime_put_autosuspend(dev);
 	if (ret < 0) {
 		dev_err(dev, "Failed to write 0x%02x to page %d reg 0x%02x: %d\n",
 			value, page, reg, ret);
 		return ret;
 	}
 
-	dev_info(dev, "Wrote 0x%02x to page %d reg 0x%02x\n", value, page, reg);
 	return count;
 }
 
-static ssize_t volume_level_show(struct device *dev,
-				 struct device_attribute *attr, char *buf)
+/**
+ * register_pages_read - dump codec registers in page-sized blocks
+ * @filp: open sysfs file
+ * @kobj: kobject of the I2C client
+ * @attr: binary attribute
+ * @buf: buffer to fill
+ * @off: flat (page * 128 + offset) address of the first register
+ * @count: number of registers to read
+ *
+ * The file maps every codec page to 128 consecutive bytes, so a whole
+ * page can be fetched with a single read. Cached registers are served
+ * from the register cache, and each run of volatile registers within a
+ * page (e.g. a whole coefficient page) is fetched with one auto-increment
+ * block read. The sticky flags clear on read and belong to the headset
+ * interrupt, so they read back as 0.
+ *
+ * Return: number of bytes read, or negative error code
+ */
+static ssize_t register_pages_read(struct file *filp, struct kobject *kobj,
+				   struct bin_attribute *attr, char *buf,
+				   loff_t off, size_t count)
 {
+	struct device *dev = kobj_to_dev(kobj);
 	struct pamir_ai_i2c_sound_data *data = dev_get_drvdata(dev);
+	unsigned int reg;
+	size_t done, len;
+	bool vol;
 	int ret;
 
-	/* Read current volume from hardware */
-	ret = pamir_ai_i2c_sound_get_volume(data);
+	ret = pm_runtime_resume_and_get(dev);
 	if (ret < 0)
 		return ret;
 
-	return sprintf(buf, "%d\n", data->volume);
-}
+	for (done = 0; done < count; done += len) {
+		reg = off + done;
+		len = 1;
+		if (pamir_ai_i2c_sound_clear_on_read(reg)) {
+			buf[done] = 0;
+			continue;
+		}
 
-static ssize_t volume_level_store(struct device *dev,
-				  struct device_attribute *attr,
-				  const char *buf, size_t count)
-{
-	struct pamir_ai_i2c_sound_data *data = dev_get_drvdata(dev);
-	int volume;
-	int ret;
+		/*
+		 * Group registers that are all cached or all volatile, a mixed
+		 * block read would be split into single transfers. Block
+		 * reads must not cross a page boundary either.
+		 */
+		vol = pamir_ai_i2c_sound_volatile_reg(dev, reg);
+		while (done + len < count && AIC3204_REG_OFFSET(reg + len) &&
+		       pamir_ai_i2c_sound_volatile_reg(dev, reg + len) == vol &&
+		       !pamir_ai_i2c_sound_clear_on_read(reg + len))
+			len++;
+
+		ret = pamir_ai_i2c_bulk_read(data, PAMIR_AI_OP_REG_ACCESS, reg,
+					     buf + done, len);
+		if (ret < 0)
+			break;
+	}
 
-	ret = kstrtoint(buf, 10, &volume);
-	if (ret < 0)
-		return ret;
+	pm_runtime_mark_last_busy(dev);
+	pm_runtime_put_autosuspend(dev);
+
+	return ret < 0 ? ret : count;
+}
+
+/**
+ * pamir_ai_i2c_sound_ramp_next - next volume level to head for while ramping
+ * @volume: current volume level
+ * @target: target volume level
+ *
+ * Within a band only the DAC moves, so the target is reached by stepping
+ * the DAC alone. Crossing a band is done at the band edges so that the
+ * HP/LO driver gain changes once per band.
+ *
+ * Return: next volume level
+ */
+static u8 pamir_ai_i2c_sound_ramp_next(u8 volume, u8 target)
+{
+	int band = PAMIR_AI_VOL_BAND(volume);
+
+	if (band == PAMIR_AI_VOL_BAND(target))
+		return target;
+
+	if (target > volume)
+		return volume == pamir_ai_volume_band_edges[band][1] ?
+			volume + 1 : pamir_ai_volume_band_edges[band][1];
+
+	return volume == pamir_ai_volume_band_edges[band][0] ?
+		volume - 1 : pamir_ai_volume_band_edges[band][0];
+}
+
+/**
+ * pamir_ai_i2c_sound_ramp_steps - register writes left in a volume ramp
+ * @volume: current volume level
+ * @dac_code: DAC volume currently programmed, in 0.5dB units
+ * @target: target volume level
+ *
+ * Every 0.5dB DAC step within a band and every band crossing is one
+ * write.
+ *
+ * Return: number of writes needed to reach @target
+ */
+static unsigned int pamir_ai_i2c_sound_ramp_steps(u8 volume, int dac_code,
+						  u8 target)
+{
+	unsigned int steps = 0;
+	u8 next;
+
+	while (volume != target) {
+		next = pamir_ai_i2c_sound_ramp_next(volume, target);
+		if (PAMIR_AI_VOL_BAND(next) != PAMIR_AI_VOL_BAND(volume))
+			steps++;
+		else
+			steps += abs((s8)PAMIR_AI_VOL_DAC(next) - dac_code);
+		dac_code = (s8)PAMIR_AI_VOL_DAC(next);
+		volume = next;
+	}
+
+	return steps;
+}
+
+/**
+ * pamir_ai_i2c_sound_ramp_step - move one step of a volume ramp
+ * @data: private data structure
+ * @target: target volume level
+ * @dac_code: updated with the DAC volume programmed, in 0.5dB units
+ *
+ * Band crossings are programmed with set_volume() in one go. Within a
+ * band the DAC volume is moved by a single 0.5dB code towards the next
+ * level, and the level itself is only recorded once the DAC gets there.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_ramp_step(struct pamir_ai_i2c_sound_data *data,
+					u8 target, int *dac_code)
+{
+	u8 next = pamir_ai_i2c_sound_ramp_next(data->volume, target);
+	int want = (s8)pamir_ai_volume_table[next].dac_val;
+	unsigned int val;
+	u8 dac_vol[2];
+	int code, ret;
+
+	if (PAMIR_AI_VOL_BAND(next) != PAMIR_AI_VOL_BAND(data->volume))
+		goto set_level;
+
+	ret = pamir_ai_i2c_read(data, PAMIR_AI_OP_VOLUME_SET, AIC3204_LDACVOL,
+				&val);
+	if (ret < 0)
+		return ret;
+
+	code = (s8)val;
+	if (code == want)
+		goto set_level;
+	code += code < want ? 1 : -1;
+	if (code == want)
+		goto set_level;
+
+	dac_vol[0] = code;
+	dac_vol[1] = code;
+	ret = pamir_ai_i2c_bulk_write(data, PAMIR_AI_OP_VOLUME_SET,
+				      AIC3204_LDACVOL, dac_vol,
+				      ARRAY_SIZE(dac_vol));
+	if (ret < 0)
+		return ret;
+
+	*dac_code = code;
+	return 0;
+
+set_level:
+	*dac_code = want;
+	return pamir_ai_i2c_sound_set_volume(data, next);
+}
+
+/**
+ * pamir_ai_i2c_sound_update_work - apply the latest requested volume/gain
+ * @work: work structure embedded in the private data
+ *
+ * Any number of sysfs writes issued since the last run are coalesced
+ * into the latest target. When a ramp time is configured the DAC volume
+ * is moved in 0.5dB steps and the bands are crossed at their edges, the
+ * remaining steps being spread evenly over the time left until the ramp
+ * expires. Without one the target is written at once and the codec
+ * soft-steps the DAC.
+ */
+static void pamir_ai_i2c_sound_update_work(struct work_struct *work)
+{
+	struct pamir_ai_i2c_sound_data *data =
+		container_of(to_delayed_work(work),
+			     struct pamir_ai_i2c_sound_data, update_work);
+	u8 target_volume, target_gain;
+	unsigned long ramp_end, now;
+	unsigned int steps;
+	int dac_code = 0;
+	int ret;
+
+	mutex_lock(&data->target_lock);
+	target_volume = data->target_volume;
+	target_gain = data->target_input_gain;
+	ramp_end = data->ramp_end;
+	mutex_unlock(&data->target_lock);
+
+	/* Ramp steps have to reach the codec, not just the cache */
+	ret = pm_runtime_resume_and_get(data->dev);
+	if (ret < 0) {
+		dev_err(data->dev, "Failed to resume codec: %d\n", ret);
+		return;
+	}
+
+	mutex_lock(&data->level_lock);
+	if (target_gain != data->input_gain) {
+		ret = pamir_ai_i2c_sound_set_input_gain(data, target_gain);
+		if (ret < 0)
+			dev_err(data->dev, "Failed to set input gain: %d\n",
+				ret);
+	}
+
+	if (target_volume == data->volume)
+		goto out_unlock;
+
+	now = jiffies;
+	if (time_before(now, ramp_end))
+		ret = pamir_ai_i2c_sound_ramp_step(data, target_volume,
+						   &dac_code);
+	else
+		ret = pamir_ai_i2c_sound_set_volume(data, target_volume);
+	if (ret < 0) {
+		dev_err(data->dev, "Failed to set volume: %d\n", ret);
+		goto out_unlock;
+	}
+
+	if (data->volume == target_volume)
+		goto out_unlock;
+
+	steps = pamir_ai_i2c_sound_ramp_steps(data->volume, dac_code,
+					      target_volume);
+	queue_delayed_work(system_wq, &data->update_work,
+			   (ramp_end - now) / max(steps, 1U));
+
+out_unlock:
+	mutex_unlock(&data->level_lock);
+
+	pm_runtime_mark_last_busy(data->dev);
+	pm_runtime_put_autosuspend(data->dev);
+}
+
+static ssize_t volume_level_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct pamir_ai_i2c_sound_data *data = dev_get_drvdata(dev);
+	u8 volume;
+	int ret;
+
+	/* Read current volume from hardware */
+	mutex_lock(&data->level_lock);
+	ret = pamir_ai_i2c_sound_get_volume(data);
+	volume = data->volume;
+	mutex_unlock(&data->level_lock);
+	if (ret < 0)
+		return ret;
+
+	return sprintf(buf, "%d\n", volume);
+}
+
+static ssize_t volume_level_store(struct device *dev,
+				  struct device_attribute *attr,
+				  const char *buf, size_t count)
+{
+	struct pamir_ai_i2c_sound_data *data = dev_get_drvdata(dev);
+	int volume;
+	int ret;
+
+	ret = kstrtoint(buf, 10, &volume);
+	if (ret < 0)
+		return ret;
 
 	if (volume < 0)
 		volume = 0;
 	else if (volume > 100)
 		volume = 100;
 
-	ret = pamir_ai_i2c_sound_set_volume(data, volume);
-	if (ret < 0)
-		return ret;
+	mutex_lock(&data->target_lock);
+	data->target_volume = volume;
+	data->ramp_end = jiffies + msecs_to_jiffies(data->ramp_ms);
+	mutex_unlock(&data->target_lock);
+
+	mod_delayed_work(system_wq, &data->update_work, 0);
 
 	return count;
 }
@@ -575,14 +1237,18 @@ static ssize_t input_gain_show(struct device *dev,
 			       struct device_attribute *attr, char *buf)
 {
 	struct pamir_ai_i2c_sound_data *data = dev_get_drvdata(dev);
+	u8 gain;
 	int ret;
 
 	/* Read current input gain from hardware */
+	mutex_lock(&data->level_lock);
 	ret = pamir_ai_i2c_sound_get_input_gain(data);
+	gain = data->input_gain;
+	mutex_unlock(&data->level_lock);
 	if (ret < 0)
 		return ret;
 
-	return sprintf(buf, "%d\n", data->input_gain);
+	return sprintf(buf, "%d\n", gain);
 }
 
 static ssize_t input_gain_store(struct device *dev,
@@ -602,99 +1268,2150 @@ static ssize_t input_gain_store(struct device *dev,
 	else if (gain > 100)
 		gain = 100;
 
-	ret = pamir_ai_i2c_sound_set_input_gain(data, gain);
+	mutex_lock(&data->target_lock);
+	data->target_input_gain = gain;
+	mutex_unlock(&data->target_lock);
+
+	mod_delayed_work(system_wq, &data->update_work, 0);
+
+	return count;
+}
+
+static ssize_t volume_ramp_ms_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct pamir_ai_i2c_sound_data *data = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%u\n", data->ramp_ms);
+}
+
+static ssize_t volume_ramp_ms_store(struct device *dev,
+				    struct device_attribute *attr,
+				    const char *buf, size_t count)
+{
+	struct pamir_ai_i2c_sound_data *data = dev_get_drvdata(dev);
+	unsigned int ramp_ms;
+	int ret;
+
+	ret = kstrtouint(buf, 10, &ramp_ms);
+	if (ret < 0)
+		return ret;
+
+	if (ramp_ms > PAMIR_AI_RAMP_MAX_MS)
+		ramp_ms = PAMIR_AI_RAMP_MAX_MS;
+
+	ret = pm_runtime_resume_and_get(dev);
+	if (ret < 0)
+		return ret;
+
+	/* Slow the codec soft-stepping down while ramping */
+	ret = pamir_ai_i2c_update_bits(data, PAMIR_AI_OP_VOLUME_SET,
+				       AIC3204_DACSETUP,
+				       AIC3204_DAC_SOFTSTEP_MASK,
+				       ramp_ms ? AIC3204_DAC_SOFTSTEP_2 :
+						 AIC3204_DAC_SOFTSTEP_1);
+	pm_runtime_mark_last_busy(dev);
+	pm_runtime_put_autosuspend(dev);
 	if (ret < 0)
 		return ret;
 
+	mutex_lock(&data->target_lock);
+	data->ramp_ms = ramp_ms;
+	mutex_unlock(&data->target_lock);
+
 	return count;
 }
 
 static DEVICE_ATTR_RW(volume_level);
 static DEVICE_ATTR_RW(input_gain);
+static DEVICE_ATTR_RW(volume_ramp_ms);
 static DEVICE_ATTR_RW(register_access);
+static BIN_ATTR_ADMIN_RO(register_pages,
+			 (AIC3204_MAX_PAGE + 1) * AIC3204_PAGE_SIZE);
 
 static struct attribute *pamir_ai_i2c_sound_attrs[] = {
 	&dev_attr_volume_level.attr,
 	&dev_attr_input_gain.attr,
+	&dev_attr_volume_ramp_ms.attr,
 	&dev_attr_register_access.attr,
 	NULL,
 };
 
+static struct bin_attribute *pamir_ai_i2c_sound_bin_attrs[] = {
+	&bin_attr_register_pages,
+	NULL,
+};
+
 static const struct attribute_group pamir_ai_i2c_sound_attr_group = {
 	.attrs = pamir_ai_i2c_sound_attrs,
+	.bin_attrs = pamir_ai_i2c_sound_bin_attrs,
 };
 
-static int pamir_ai_i2c_sound_probe(struct i2c_client *client)
+static const char * const pamir_ai_i2c_op_names[PAMIR_AI_OP_COUNT] = {
+	[PAMIR_AI_OP_INIT] = "init",
+	[PAMIR_AI_OP_VOLUME_SET] = "volume_set",
+	[PAMIR_AI_OP_VOLUME_GET] = "volume_get",
+	[PAMIR_AI_OP_GAIN_SET] = "gain_set",
+	[PAMIR_AI_OP_GAIN_GET] = "gain_get",
+	[PAMIR_AI_OP_REG_ACCESS] = "reg_access",
+	[PAMIR_AI_OP_CLOCKS] = "clocks",
+	[PAMIR_AI_OP_DSP] = "dsp",
+};
+
+/* Upper edge in us of the bucket holding the @pct percentile */
+VISIBLE_IF_KUNIT unsigned int
+pamir_ai_i2c_percentile(const struct pamir_ai_i2c_stats *stats,
+			unsigned int pct)
 {
-	struct pamir_ai_i2c_sound_data *data;
-	int i, ret;
+	u64 rank, seen = 0;
+	unsigned int i;
+
+	rank = DIV_ROUND_UP_ULL(stats->transactions * pct, 100);
+	for (i = 0; i < PAMIR_AI_LAT_BUCKETS - 1; i++) {
+		seen += stats->hist[i];
+		if (seen >= rank)
+			break;
+	}
 
-	data = devm_kzalloc(&client->dev, sizeof(*data), GFP_KERNEL);
-	if (!data)
-		return -ENOMEM;
+	return 1U << i;
+}
+EXPORT_SYMBOL_IF_KUNIT(pamir_ai_i2c_percentile);
 
-	data->client = client;
-	data->dev = &client->dev;
-	data->volume = 50;
-	data->input_gain = 50;
+/**
+ * pamir_ai_i2c_stats_show - print the register access statistics
+ * @s: seq_file of the debugfs i2c_stats file
+ * @unused: unused
+ *
+ * Prints one line per operation type followed by its latency
+ * histogram. Percentiles are given as the upper edge of the histogram
+ * bucket they fall in.
+ *
+ * Return: 0
+ */
+static int pamir_ai_i2c_stats_show(struct seq_file *s, void *unused)
+{
+	struct pamir_ai_i2c_sound_data *data = s->private;
+	struct pamir_ai_i2c_stats stats;
+	unsigned int op, i;
+
+	seq_printf(s, "%-12s %12s %8s %8s %8s %8s %8s  histogram (us: <1 <2 <4 ...)\n",
+		   "op", "transactions", "retries", "naks", "errors", "p50_us",
+		   "p99_us");
+
+	for (op = 0; op < PAMIR_AI_OP_COUNT; op++) {
+		spin_lock(&data->stats_lock);
+		stats = data->stats[op];
+		spin_unlock(&data->stats_lock);
+
+		seq_printf(s, "%-12s %12llu %8llu %8llu %8llu %8u %8u ",
+			   pamir_ai_i2c_op_names[op], stats.transactions,
+			   stats.retries, stats.naks, stats.errors,
+			   stats.transactions ?
+			   pamir_ai_i2c_percentile(&stats, 50) : 0,
+			   stats.transactions ?
+			   pamir_ai_i2c_percentile(&stats, 99) : 0);
+		for (i = 0; i < PAMIR_AI_LAT_BUCKETS; i++)
+			seq_printf(s, " %u", stats.hist[i]);
+		seq_puts(s, "\n");
+	}
 
-	i2c_set_clientdata(client, data);
-	dev_set_drvdata(&client->dev, data);
+	return 0;
+}
 
-	dev_info(&client->dev, "Starting initialization sequence\n");
-	for (i = 0; i < ARRAY_SIZE(init_sequence); i++) {
-		ret = i2c_smbus_write_byte_data(client, init_sequence[i].reg,
-						init_sequence[i].val);
-		if (ret < 0) {
-			dev_err(&client->dev,
-				"Failed to write reg 0x%02x with value 0x%02x: %d\n",
-				init_sequence[i].reg, init_sequence[i].val,
-				ret);
+static int pamir_ai_i2c_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, pamir_ai_i2c_stats_show, inode->i_private);
+}
+
+/* Any write clears the statistics, e.g. before a benchmark run */
+static ssize_t pamir_ai_i2c_stats_write(struct file *file,
+					const char __user *buf, size_t count,
+					loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct pamir_ai_i2c_sound_data *data = s->private;
+
+	spin_lock(&data->stats_lock);
+	memset(data->stats, 0, sizeof(data->stats));
+	spin_unlock(&data->stats_lock);
+
+	return count;
+}
+
+static const struct file_operations pamir_ai_i2c_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = pamir_ai_i2c_stats_open,
+	.read = seq_read,
+	.write = pamir_ai_i2c_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static const DECLARE_TLV_DB_SCALE(tlv_dac_vol, -6350, 50, 0);
+static const DECLARE_TLV_DB_SCALE(tlv_driver_gain, -600, 100, 0);
+static const DECLARE_TLV_DB_SCALE(tlv_adc_vol, -1200, 50, 0);
+static const DECLARE_TLV_DB_SCALE(tlv_pga_vol, 0, 50, 0);
+static const DECLARE_TLV_DB_SCALE(tlv_agc_gain, -1200, 50, 0);
+
+static const char * const pamir_ai_agc_target_text[] = {
+	"-5.5dB", "-8dB", "-10dB", "-12dB", "-14dB", "-17dB", "-20dB", "-24dB",
+};
+
+static SOC_ENUM_SINGLE_DECL(pamir_ai_left_agc_target, AIC3204_LAGCCTL1,
+			    AIC3204_AGC_TARGET_SHIFT, pamir_ai_agc_target_text);
+static SOC_ENUM_SINGLE_DECL(pamir_ai_right_agc_target, AIC3204_RAGCCTL1,
+			    AIC3204_AGC_TARGET_SHIFT, pamir_ai_agc_target_text);
+
+/*
+ * The gain the AGC currently applies to the MICPGA. It only moves while
+ * capturing, so an idle codec is not woken up and reports 0 dB.
+ */
+static int pamir_ai_agc_gain_get(struct snd_kcontrol *kcontrol,
+				 struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_kcontrol_chip(kcontrol);
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(component);
+	unsigned int left = 0, right = 0;
+	int ret = 0;
+
+	if (pm_runtime_get_if_in_use(data->dev) > 0) {
+		ret = regmap_read(data->regmap, AIC3204_LAGCGAIN, &left);
+		if (!ret)
+			ret = regmap_read(data->regmap, AIC3204_RAGCGAIN,
+					  &right);
+		pm_runtime_mark_last_busy(data->dev);
+		pm_runtime_put_autosuspend(data->dev);
+		if (ret < 0)
+			return ret;
+	}
+
+	ucontrol->value.integer.value[0] = (s8)left - AIC3204_AGC_MIN_APPLIED;
+	ucontrol->value.integer.value[1] = (s8)right - AIC3204_AGC_MIN_APPLIED;
+	return 0;
+}
+
+static int pamir_ai_low_latency_get(struct snd_kcontrol *kcontrol,
+				    struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_kcontrol_chip(kcontrol);
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(component);
+
+	ucontrol->value.integer.value[0] = data->low_latency;
+	return 0;
+}
+
+/* The processing blocks can only be changed with the DAC and ADC stopped */
+static int pamir_ai_low_latency_put(struct snd_kcontrol *kcontrol,
+				    struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_kcontrol_chip(kcontrol);
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(component);
+	bool low_latency = ucontrol->value.integer.value[0];
+
+	if (low_latency == data->low_latency)
+		return 0;
+
+	if (snd_soc_component_active(component))
+		return -EBUSY;
+
+	data->low_latency = low_latency;
+	return 1;
+}
+
+static int pamir_ai_group_delay_get(struct snd_kcontrol *kcontrol,
+				    struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_kcontrol_chip(kcontrol);
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(component);
+
+	ucontrol->value.integer.value[0] = data->dac_delay;
+	ucontrol->value.integer.value[1] = data->adc_delay;
+	return 0;
+}
+
+/*
+ * Coefficient RAM of the processing blocks. Each path has two buffers the
+ * codec swaps between on a frame boundary in adaptive filtering mode, so
+ * a new coefficient set is written to the idle buffer and then switched
+ * in without disturbing a running stream.
+ */
+struct pamir_ai_coef_buf {
+	unsigned int ctrl;
+	unsigned int power_reg;
+	u8 page_a;
+	u8 page_b;
+};
+
+static const struct pamir_ai_coef_buf pamir_ai_coef_bufs[] = {
+	{ AIC3204_ADC_ADAPTIVE, AIC3204_ADCSETUP,
+	  AIC3204_ADC_COEF_A_PAGE, AIC3204_ADC_COEF_B_PAGE },
+	{ AIC3204_DAC_ADAPTIVE, AIC3204_DACSETUP,
+	  AIC3204_DAC_COEF_A_PAGE, AIC3204_DAC_COEF_B_PAGE },
+};
+
+#define PAMIR_AI_COEF_PATHS	ARRAY_SIZE(pamir_ai_coef_bufs)
+#define PAMIR_AI_COEF_SIZE	(PAMIR_AI_COEF_PATHS * \
+				 sizeof(u8[AIC3204_COEF_PAGES][AIC3204_COEF_LEN]))
+/* Buffer switch completes on the next frame, even at 8 kHz */
+#define PAMIR_AI_COEF_SWITCH_US	10000
+
+/*
+ * Coefficient firmware "pamir-ai-dsp-<profile>.bin": the magic followed
+ * by blocks of { page, reg, len, data[len] }, addressed to buffer A of the
+ * ADC (pages 8-16) or DAC (pages 44-52) coefficient RAM. Coefficients not
+ * covered by a block keep their power-on value.
+ */
+#define PAMIR_AI_DSP_FW_MAGIC	"PDSP"
+
+static int pamir_ai_i2c_sound_write_coefs(struct pamir_ai_i2c_sound_data *data,
+					  unsigned int page,
+					  const u8 (*coefs)[AIC3204_COEF_LEN])
+{
+	int i, ret;
+
+	for (i = 0; i < AIC3204_COEF_PAGES; i++) {
+		ret = pamir_ai_i2c_bulk_write(data, PAMIR_AI_OP_DSP,
+					      AIC3204_REG(page + i,
+							  AIC3204_COEF_REG_MIN),
+					      coefs[i], AIC3204_COEF_LEN);
+		if (ret < 0)
 			return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * pamir_ai_i2c_sound_init_coefs - enable adaptive filtering after a reset
+ * @data: private data structure
+ *
+ * The coefficient RAM is not cached, so any set other than the power-on
+ * one is written back to buffer A, the one in use straight after reset,
+ * before adaptive filtering is turned on. Called with the processing
+ * blocks powered down.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_init_coefs(struct pamir_ai_i2c_sound_data *data)
+{
+	int i, ret = 0;
+
+	mutex_lock(&data->dsp_lock);
+	for (i = 0; i < PAMIR_AI_COEF_PATHS && !ret; i++) {
+		if (memcmp(data->coefs[i], data->coef_defaults[i],
+			   sizeof(data->coefs[i]))) {
+			ret = pamir_ai_i2c_sound_write_coefs(data,
+					pamir_ai_coef_bufs[i].page_a,
+					data->coefs[i]);
+			if (ret < 0)
+				break;
 		}
-		dev_info(&client->dev, "Wrote 0x%02x to reg 0x%02x\n",
-			 init_sequence[i].val, init_sequence[i].reg);
+
+		ret = pamir_ai_i2c_write(data, PAMIR_AI_OP_DSP,
+					 pamir_ai_coef_bufs[i].ctrl,
+					 AIC3204_ADAPTIVE_ENABLE);
 	}
-	dev_info(&client->dev,
-		 "Initialization sequence completed successfully\n");
+	mutex_unlock(&data->dsp_lock);
 
-	/* Create sysfs interface */
-	ret = sysfs_create_group(&client->dev.kobj, &pamir_ai_i2c_sound_attr_group);
-	if (ret < 0) {
-		dev_err(&client->dev, "Failed to create sysfs group: %d\n",
-			ret);
+	return ret;
+}
+
+/**
+ * pamir_ai_i2c_sound_switch_coefs - swap in a new coefficient set
+ * @data: private data structure
+ * @path: index in pamir_ai_coef_bufs
+ * @coefs: new coefficients for the path
+ *
+ * A powered down path only completes the switch once it is started
+ * again, which is still atomic from the point of view of the stream.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_switch_coefs(struct pamir_ai_i2c_sound_data *data,
+					   int path,
+					   const u8 (*coefs)[AIC3204_COEF_LEN])
+{
+	const struct pamir_ai_coef_buf *buf = &pamir_ai_coef_bufs[path];
+	unsigned int val;
+	int ret;
+
+	ret = pamir_ai_i2c_read(data, PAMIR_AI_OP_DSP, buf->ctrl, &val);
+	if (ret < 0)
 		return ret;
-	}
 
-	/* Set initial volume and input gain */
-	ret = pamir_ai_i2c_sound_set_volume(data, data->volume);
-	if (ret < 0) {
-		dev_err(&client->dev, "Failed to set initial volume: %d\n",
-			ret);
-		sysfs_remove_group(&client->dev.kobj,
-				   &pamir_ai_i2c_sound_attr_group);
+	ret = pamir_ai_i2c_sound_write_coefs(data, val & AIC3204_ADAPTIVE_BUF_B ?
+					     buf->page_a : buf->page_b, coefs);
+	if (ret < 0)
 		return ret;
-	}
 
-	ret = pamir_ai_i2c_sound_set_input_gain(data, data->input_gain);
-	if (ret < 0) {
-		dev_err(&client->dev, "Failed to set initial input gain: %d\n",
-			ret);
-		sysfs_remove_group(&client->dev.kobj,
-				   &pamir_ai_i2c_sound_attr_group);
+	ret = pamir_ai_i2c_update_bits(data, PAMIR_AI_OP_DSP, buf->ctrl,
+				       AIC3204_ADAPTIVE_SWITCH,
+				       AIC3204_ADAPTIVE_SWITCH);
+	if (ret < 0)
 		return ret;
-	}
 
-	return 0;
+	ret = pamir_ai_i2c_read(data, PAMIR_AI_OP_DSP, buf->power_reg, &val);
+	if (ret < 0 || !(val & GENMASK(7, 6)))
+		return ret;
+
+	ret = regmap_read_poll_timeout(data->regmap, buf->ctrl, val,
+				       !(val & AIC3204_ADAPTIVE_SWITCH),
+				       1000, PAMIR_AI_COEF_SWITCH_US);
+	if (ret < 0)
+		dev_err(data->dev, "Coefficient buffer switch timed out\n");
+
+	return ret;
 }
 
-static void pamir_ai_i2c_sound_remove(struct i2c_client *client)
+static int pamir_ai_i2c_sound_parse_coefs(struct pamir_ai_i2c_sound_data *data,
+					  const struct firmware *fw,
+					  u8 (*coefs)[AIC3204_COEF_PAGES][AIC3204_COEF_LEN])
 {
-	struct pamir_ai_i2c_sound_data *data = i2c_get_clientdata(client);
+	size_t pos = strlen(PAMIR_AI_DSP_FW_MAGIC);
+	unsigned int page, reg, len;
+	int i;
 
-	if (data)
-		sysfs_remove_group(&client->dev.kobj,
-				   &pamir_ai_i2c_sound_attr_group);
+	if (fw->size < pos || memcmp(fw->data, PAMIR_AI_DSP_FW_MAGIC, pos))
+		return -EINVAL;
+
+	while (pos < fw->size) {
+		if (fw->size - pos < 3)
+			return -EINVAL;
+
+		page = fw->data[pos];
+		reg = fw->data[pos + 1];
+		len = fw->data[pos + 2];
+		pos += 3;
+
+		if (fw->size - pos < len || reg < AIC3204_COEF_REG_MIN ||
+		    reg + len > AIC3204_PAGE_SIZE)
+			return -EINVAL;
+
+		for (i = 0; i < PAMIR_AI_COEF_PATHS; i++)
+			if (page >= pamir_ai_coef_bufs[i].page_a &&
+			    page < pamir_ai_coef_bufs[i].page_a +
+				   AIC3204_COEF_PAGES)
+				break;
+		if (i == PAMIR_AI_COEF_PATHS)
+			return -EINVAL;
+
+		memcpy(&coefs[i][page - pamir_ai_coef_bufs[i].page_a]
+			     [reg - AIC3204_COEF_REG_MIN],
+		       &fw->data[pos], len);
+		pos += len;
+	}
+
+	return 0;
+}
+
+/**
+ * pamir_ai_i2c_sound_set_profile - load and switch to a coefficient set
+ * @data: private data structure
+ * @profile: index in @data->dsp_profiles, 0 for the power-on coefficients
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_set_profile(struct pamir_ai_i2c_sound_data *data,
+					  unsigned int profile)
+{
+	u8 (*coefs)[AIC3204_COEF_PAGES][AIC3204_COEF_LEN];
+	const struct firmware *fw;
+	char *name;
+	int i, ret;
+
+	/* Profiles are built on top of the power-on coefficients */
+	wait_for_completion(&data->dsp_ready);
+	if (data->dsp_err)
+		return data->dsp_err;
+
+	coefs = kmemdup(data->coef_defaults, PAMIR_AI_COEF_SIZE, GFP_KERNEL);
+	if (!coefs)
+		return -ENOMEM;
+
+	if (profile) {
+		name = kasprintf(GFP_KERNEL, "pamir-ai-dsp-%s.bin",
+				 data->dsp_profiles[profile]);
+		if (!name) {
+			ret = -ENOMEM;
+			goto out_free;
+		}
+
+		ret = request_firmware(&fw, name, data->dev);
+		if (ret < 0) {
+			dev_err(data->dev, "Failed to load %s: %d\n", name, ret);
+			kfree(name);
+			goto out_free;
+		}
+
+		ret = pamir_ai_i2c_sound_parse_coefs(data, fw, coefs);
+		if (ret < 0)
+			dev_err(data->dev, "Invalid coefficient file %s\n", name);
+		release_firmware(fw);
+		kfree(name);
+		if (ret < 0)
+			goto out_free;
+	}
+
+	/* Resume rewrites @coefs itself, so wake the codec before locking */
+	ret = pm_runtime_resume_and_get(data->dev);
+	if (ret < 0)
+		goto out_free;
+
+	mutex_lock(&data->dsp_lock);
+	for (i = 0; i < PAMIR_AI_COEF_PATHS; i++) {
+		if (!memcmp(coefs[i], data->coefs[i], sizeof(coefs[i])))
+			continue;
+
+		ret = pamir_ai_i2c_sound_switch_coefs(data, i, coefs[i]);
+		if (ret < 0)
+			break;
+		memcpy(data->coefs[i], coefs[i], sizeof(coefs[i]));
+	}
+	if (!ret)
+		data->dsp_profile = profile;
+	mutex_unlock(&data->dsp_lock);
+
+	pm_runtime_mark_last_busy(data->dev);
+	pm_runtime_put_autosuspend(data->dev);
+out_free:
+	kfree(coefs);
+	return ret;
+}
+
+static int pamir_ai_dsp_profile_get(struct snd_kcontrol *kcontrol,
+				    struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_kcontrol_chip(kcontrol);
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(component);
+
+	mutex_lock(&data->dsp_lock);
+	ucontrol->value.enumerated.item[0] = data->dsp_profile;
+	mutex_unlock(&data->dsp_lock);
+	return 0;
+}
+
+static int pamir_ai_dsp_profile_put(struct snd_kcontrol *kcontrol,
+				    struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_kcontrol_chip(kcontrol);
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(component);
+	unsigned int profile = ucontrol->value.enumerated.item[0];
+	int ret;
+
+	if (profile >= data->dsp_enum.items)
+		return -EINVAL;
+
+	if (profile == data->dsp_profile)
+		return 0;
+
+	ret = pamir_ai_i2c_sound_set_profile(data, profile);
+	return ret < 0 ? ret : 1;
+}
+
+/**
+ * pamir_ai_i2c_sound_dsp_work - record the power-on coefficients
+ * @work: work struct embedded in the private data
+ *
+ * The "Flat" profile and profiles only touching part of the RAM fall
+ * back to the power-on coefficients. Reading both RAMs is the slowest
+ * part of the codec bring-up, about 2 kB over the bus, so it runs once
+ * the component is registered instead of holding up the card. Until
+ * then @coefs and @coef_defaults are both zero, so a resume does not
+ * write the RAM, and profile switches wait for @dsp_ready.
+ */
+static void pamir_ai_i2c_sound_dsp_work(struct work_struct *work)
+{
+	struct pamir_ai_i2c_sound_data *data =
+		container_of(work, struct pamir_ai_i2c_sound_data, dsp_work);
+	u8 (*defaults)[AIC3204_COEF_PAGES][AIC3204_COEF_LEN];
+	int i, j, ret;
+
+	defaults = kzalloc(PAMIR_AI_COEF_SIZE, GFP_KERNEL);
+	if (!defaults) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	ret = pm_runtime_resume_and_get(data->dev);
+	if (ret < 0)
+		goto out_free;
+
+	for (i = 0; i < PAMIR_AI_COEF_PATHS && !ret; i++) {
+		for (j = 0; j < AIC3204_COEF_PAGES && !ret; j++)
+			ret = pamir_ai_i2c_bulk_read(data, PAMIR_AI_OP_INIT,
+					AIC3204_REG(pamir_ai_coef_bufs[i].page_a + j,
+						    AIC3204_COEF_REG_MIN),
+					defaults[i][j], AIC3204_COEF_LEN);
+	}
+
+	if (!ret) {
+		mutex_lock(&data->dsp_lock);
+		memcpy(data->coef_defaults, defaults, PAMIR_AI_COEF_SIZE);
+		memcpy(data->coefs, defaults, PAMIR_AI_COEF_SIZE);
+		mutex_unlock(&data->dsp_lock);
+	}
+
+	pm_runtime_mark_last_busy(data->dev);
+	pm_runtime_put_autosuspend(data->dev);
+out_free:
+	kfree(defaults);
+out:
+	if (ret < 0)
+		dev_err(data->dev, "Failed to read coefficient RAM: %d\n", ret);
+	data->dsp_err = ret;
+	complete_all(&data->dsp_ready);
+}
+
+/**
+ * pamir_ai_i2c_sound_init_dsp - set up coefficient profile switching
+ * @data: private data structure
+ *
+ * Turns on adaptive filtering. Profile names come from
+ * "pamir-ai,dsp-profiles", the power-on coefficients are recorded later
+ * by pamir_ai_i2c_sound_dsp_work().
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_init_dsp(struct pamir_ai_i2c_sound_data *data)
+{
+	int count, ret;
+
+	data->coef_defaults = devm_kzalloc(data->dev, PAMIR_AI_COEF_SIZE,
+					   GFP_KERNEL);
+	data->coefs = devm_kzalloc(data->dev, PAMIR_AI_COEF_SIZE, GFP_KERNEL);
+	if (!data->coef_defaults || !data->coefs)
+		return -ENOMEM;
+
+	count = device_property_string_array_count(data->dev,
+						   "pamir-ai,dsp-profiles");
+	if (count < 0)
+		count = 0;
+
+	data->dsp_profiles = devm_kcalloc(data->dev, count + 1,
+					  sizeof(*data->dsp_profiles),
+					  GFP_KERNEL);
+	if (!data->dsp_profiles)
+		return -ENOMEM;
+
+	data->dsp_profiles[0] = "Flat";
+	if (count) {
+		ret = device_property_read_string_array(data->dev,
+							"pamir-ai,dsp-profiles",
+							&data->dsp_profiles[1],
+							count);
+		if (ret < 0)
+			return ret;
+	}
+
+	data->dsp_enum.reg = SND_SOC_NOPM;
+	data->dsp_enum.items = count + 1;
+	data->dsp_enum.texts = data->dsp_profiles;
+
+	return pamir_ai_i2c_sound_init_coefs(data);
+}
+
+static const struct snd_kcontrol_new pamir_ai_snd_controls[] = {
+	SOC_DOUBLE_R_S_TLV("PCM Playback Volume", AIC3204_LDACVOL,
+			   AIC3204_RDACVOL, 0, -0x7f, 0x30, 7, 0, tlv_dac_vol),
+	SOC_DOUBLE_R_S_TLV("Headphone Playback Volume", AIC3204_HPLGAIN,
+			   AIC3204_HPRGAIN, 0, -0x06, 0x1d, 5, 0,
+			   tlv_driver_gain),
+	SOC_DOUBLE_R("Headphone Playback Switch", AIC3204_HPLGAIN,
+		     AIC3204_HPRGAIN, 6, 0x01, 1),
+	SOC_DOUBLE_R_S_TLV("Line Out Playback Volume", AIC3204_LOLGAIN,
+			   AIC3204_LORGAIN, 0, -0x06, 0x1d, 5, 0,
+			   tlv_driver_gain),
+	SOC_DOUBLE_R("Line Out Playback Switch", AIC3204_LOLGAIN,
+		     AIC3204_LORGAIN, 6, 0x01, 1),
+	SOC_DOUBLE_R_S_TLV("ADC Capture Volume", AIC3204_LADCVOL,
+			   AIC3204_RADCVOL, 0, -0x18, 0x28, 6, 0, tlv_adc_vol),
+	SOC_DOUBLE_R_TLV("PGA Capture Volume", AIC3204_LMICPGAVOL,
+			 AIC3204_RMICPGAVOL, 0, 0x5f, 0, tlv_pga_vol),
+	SOC_SINGLE_BOOL_EXT("Low Latency Switch", 0, pamir_ai_low_latency_get,
+			    pamir_ai_low_latency_put),
+	{
+		/* Playback and capture group delay in frames, read-only */
+		.iface = SNDRV_CTL_ELEM_IFACE_MIXER,
+		.name = "Codec Group Delay",
+		.access = SNDRV_CTL_ELEM_ACCESS_READ |
+			  SNDRV_CTL_ELEM_ACCESS_VOLATILE,
+		.info = snd_soc_info_volsw,
+		.get = pamir_ai_group_delay_get,
+		.private_value = SOC_DOUBLE_VALUE(SND_SOC_NOPM, 0, 1,
+						  PAMIR_AI_DAC_DELAY, 0, 0),
+	},
+	/* Hardware AGC driving the MICPGA gain */
+	SOC_DOUBLE_R("AGC Capture Switch", AIC3204_LAGCCTL1,
+		     AIC3204_RAGCCTL1, 7, 0x01, 0),
+	SOC_ENUM("Left AGC Target Level", pamir_ai_left_agc_target),
+	SOC_ENUM("Right AGC Target Level", pamir_ai_right_agc_target),
+	SOC_DOUBLE_R_TLV("AGC Max Gain Capture Volume", AIC3204_LAGCMAXGAIN,
+			 AIC3204_RAGCMAXGAIN, 0, AIC3204_AGC_MAX_GAIN, 0,
+			 tlv_pga_vol),
+	SOC_DOUBLE_R("AGC Noise Threshold", AIC3204_LAGCCTL2,
+		     AIC3204_RAGCCTL2, AIC3204_AGC_NOISE_SHIFT, 0x1f, 0),
+	SOC_DOUBLE_R("AGC Attack Time", AIC3204_LAGCATTACK, AIC3204_RAGCATTACK,
+		     AIC3204_AGC_TIME_SHIFT, 0x1f, 0),
+	SOC_DOUBLE_R("AGC Attack Scale", AIC3204_LAGCATTACK,
+		     AIC3204_RAGCATTACK, 0, 0x07, 0),
+	SOC_DOUBLE_R("AGC Decay Time", AIC3204_LAGCDECAY, AIC3204_RAGCDECAY,
+		     AIC3204_AGC_TIME_SHIFT, 0x1f, 0),
+	SOC_DOUBLE_R("AGC Decay Scale", AIC3204_LAGCDECAY, AIC3204_RAGCDECAY,
+		     0, 0x07, 0),
+	{
+		/* AGC gain applied to the MICPGA, read-only */
+		.iface = SNDRV_CTL_ELEM_IFACE_MIXER,
+		.name = "AGC Applied Capture Volume",
+		.access = SNDRV_CTL_ELEM_ACCESS_READ |
+			  SNDRV_CTL_ELEM_ACCESS_TLV_READ |
+			  SNDRV_CTL_ELEM_ACCESS_VOLATILE,
+		.tlv.p = tlv_agc_gain,
+		.info = snd_soc_info_volsw,
+		.get = pamir_ai_agc_gain_get,
+		.private_value = SOC_DOUBLE_R_VALUE(AIC3204_LAGCGAIN,
+						    AIC3204_RAGCGAIN, 0,
+						    AIC3204_AGC_MAX_GAIN -
+						    AIC3204_AGC_MIN_APPLIED, 0),
+	},
+};
+
+/**
+ * pamir_ai_i2c_sound_drv_event - wait for an output driver to settle
+ * @w: HP/LO driver widget
+ * @kcontrol: unused
+ * @event: DAPM event
+ *
+ * The driver only reports powered up once the reference has charged and
+ * its de-pop ramp has finished. DAPM powers the outputs before the stream
+ * is started, so waiting here keeps the first samples from being played
+ * into a ramping output, without a fixed delay.
+ *
+ * Return: 0, a driver that does not settle in time is only reported
+ */
+static int pamir_ai_i2c_sound_drv_event(struct snd_soc_dapm_widget *w,
+					struct snd_kcontrol *kcontrol,
+					int event)
+{
+	struct snd_soc_component *component = snd_soc_dapm_to_component(w->dapm);
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(component);
+	unsigned int flag, val;
+	int ret;
+
+	switch (w->shift) {
+	case 5:
+		flag = AIC3204_DACFLAG_HPL;
+		break;
+	case 4:
+		flag = AIC3204_DACFLAG_HPR;
+		break;
+	case 3:
+		flag = AIC3204_DACFLAG_LOL;
+		break;
+	case 2:
+		flag = AIC3204_DACFLAG_LOR;
+		break;
+	default:
+		return 0;
+	}
+
+	ret = regmap_read_poll_timeout(data->regmap, AIC3204_DACFLAG1, val,
+				       val & flag, 1000,
+				       data->settle_timeout_ms * USEC_PER_MSEC);
+	if (ret < 0)
+		dev_warn(data->dev, "%s not settled after %u ms: %d\n",
+			 w->name, data->settle_timeout_ms, ret);
+
+	return 0;
+}
+
+/*
+ * Capture mode: DOUT carries either the ADC output or, looped back on
+ * the interface, the playback data received on DIN. The codec can only
+ * switch DOUT as a whole, so the loopback replaces both microphone
+ * channels and is no echo reference next to the microphones; it is a
+ * diagnostic mode for checking what reaches the codec.
+ */
+static const char * const pamir_ai_capture_mode_text[] = {
+	"Microphones", "Playback Loopback",
+};
+
+static SOC_ENUM_SINGLE_DECL(pamir_ai_capture_mode_enum, AIC3204_IFACE2,
+			    AIC3204_DIN_DOUT_LOOPBACK_SHIFT,
+			    pamir_ai_capture_mode_text);
+
+static const struct snd_kcontrol_new pamir_ai_capture_mode =
+	SOC_DAPM_ENUM("Capture Mode", pamir_ai_capture_mode_enum);
+
+static const struct snd_soc_dapm_widget pamir_ai_dapm_widgets[] = {
+	SND_SOC_DAPM_SUPPLY("AVDD LDO", AIC3204_LDOCTL, 0, 0, NULL, 0),
+	SND_SOC_DAPM_SUPPLY("Analog Power", AIC3204_LDOCTL, 3, 1, NULL, 0),
+	SND_SOC_DAPM_SUPPLY("Mic Bias", AIC3204_MICBIAS, 6, 0, NULL, 0),
+
+	SND_SOC_DAPM_AIF_IN("AIF IN", "HiFi Playback", 0, SND_SOC_NOPM, 0, 0),
+	SND_SOC_DAPM_AIF_OUT("AIF OUT", "HiFi Capture", 0, SND_SOC_NOPM, 0, 0),
+	SND_SOC_DAPM_MUX("Capture Mode", SND_SOC_NOPM, 0, 0,
+			 &pamir_ai_capture_mode),
+
+	SND_SOC_DAPM_DAC("Left DAC", NULL, AIC3204_DACSETUP, 7, 0),
+	SND_SOC_DAPM_DAC("Right DAC", NULL, AIC3204_DACSETUP, 6, 0),
+	SND_SOC_DAPM_PGA_E("HPL Driver", AIC3204_OUTPWRCTL, 5, 0, NULL, 0,
+			   pamir_ai_i2c_sound_drv_event, SND_SOC_DAPM_POST_PMU),
+	SND_SOC_DAPM_PGA_E("HPR Driver", AIC3204_OUTPWRCTL, 4, 0, NULL, 0,
+			   pamir_ai_i2c_sound_drv_event, SND_SOC_DAPM_POST_PMU),
+	SND_SOC_DAPM_PGA_E("LOL Driver", AIC3204_OUTPWRCTL, 3, 0, NULL, 0,
+			   pamir_ai_i2c_sound_drv_event, SND_SOC_DAPM_POST_PMU),
+	SND_SOC_DAPM_PGA_E("LOR Driver", AIC3204_OUTPWRCTL, 2, 0, NULL, 0,
+			   pamir_ai_i2c_sound_drv_event, SND_SOC_DAPM_POST_PMU),
+	SND_SOC_DAPM_OUTPUT("HPL"),
+	SND_SOC_DAPM_OUTPUT("HPR"),
+	SND_SOC_DAPM_OUTPUT("LOL"),
+	SND_SOC_DAPM_OUTPUT("LOR"),
+
+	SND_SOC_DAPM_INPUT("IN1_L"),
+	SND_SOC_DAPM_INPUT("IN1_R"),
+	/* MICPGA gain is forced to 0dB while the PGA is unused */
+	SND_SOC_DAPM_PGA("Left MicPGA", AIC3204_LMICPGAVOL, 7, 1, NULL, 0),
+	SND_SOC_DAPM_PGA("Right MicPGA", AIC3204_RMICPGAVOL, 7, 1, NULL, 0),
+	SND_SOC_DAPM_ADC("Left ADC", NULL, AIC3204_ADCSETUP, 7, 0),
+	SND_SOC_DAPM_ADC("Right ADC", NULL, AIC3204_ADCSETUP, 6, 0),
+};
+
+static const struct snd_soc_dapm_route pamir_ai_dapm_routes[] = {
+	{ "Analog Power", NULL, "AVDD LDO" },
+
+	/* Playback: DAC to headphone and line out drivers */
+	{ "Left DAC", NULL, "AIF IN" },
+	{ "Right DAC", NULL, "AIF IN" },
+	{ "Left DAC", NULL, "Analog Power" },
+	{ "Right DAC", NULL, "Analog Power" },
+	{ "HPL Driver", NULL, "Left DAC" },
+	{ "HPR Driver", NULL, "Right DAC" },
+	{ "LOL Driver", NULL, "Left DAC" },
+	{ "LOR Driver", NULL, "Right DAC" },
+	{ "HPL", NULL, "HPL Driver" },
+	{ "HPR", NULL, "HPR Driver" },
+	{ "LOL", NULL, "LOL Driver" },
+	{ "LOR", NULL, "LOR Driver" },
+
+	/* Capture: IN1 through the MICPGA to the ADC */
+	{ "Left MicPGA", NULL, "IN1_L" },
+	{ "Right MicPGA", NULL, "IN1_R" },
+	{ "Left MicPGA", NULL, "Analog Power" },
+	{ "Right MicPGA", NULL, "Analog Power" },
+	{ "Left ADC", NULL, "Left MicPGA" },
+	{ "Right ADC", NULL, "Right MicPGA" },
+	{ "Capture Mode", "Microphones", "Left ADC" },
+	{ "Capture Mode", "Microphones", "Right ADC" },
+	{ "Capture Mode", "Playback Loopback", "AIF IN" },
+	{ "AIF OUT", NULL, "Capture Mode" },
+};
+
+/* Only used when the microphone has to be biased by the codec */
+static const struct snd_soc_dapm_route pamir_ai_micbias_routes[] = {
+	{ "IN1_L", NULL, "Mic Bias" },
+	{ "IN1_R", NULL, "Mic Bias" },
+};
+
+/* Called with the codec runtime active and @data->jack_lock held */
+static int pamir_ai_i2c_sound_report_jack(struct pamir_ai_i2c_sound_data *data)
+{
+	unsigned int val;
+	int ret, status = 0;
+
+	if (!data->jack)
+		return 0;
+
+	ret = regmap_read(data->regmap, AIC3204_HEADSETDETECT, &val);
+	if (ret < 0)
+		return ret;
+
+	switch (val & AIC3204_HSDET_STATUS_MASK) {
+	case AIC3204_HSDET_HEADPHONE:
+		status = SND_JACK_HEADPHONE;
+		break;
+	case AIC3204_HSDET_HEADSET:
+		status = SND_JACK_HEADSET;
+		break;
+	}
+
+	snd_soc_jack_report(data->jack, status, SND_JACK_HEADSET);
+	return 0;
+}
+
+/**
+ * pamir_ai_i2c_sound_init_jack - (re)arm headset detection
+ * @data: private data structure
+ *
+ * The detection configuration shares its register with the volatile
+ * status bits, so it is not restored by regcache_sync(). The status is
+ * only valid once the debounce time has passed, so it is left to the
+ * interrupt to report the jack rather than read back here.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_init_jack(struct pamir_ai_i2c_sound_data *data)
+{
+	int ret;
+
+	mutex_lock(&data->jack_lock);
+	ret = regmap_write(data->regmap, AIC3204_HEADSETDETECT,
+			   data->jack ? AIC3204_HSDET_ENABLE |
+					AIC3204_HSDET_DEBOUNCE_128MS : 0);
+	if (!ret)
+		ret = regmap_update_bits(data->regmap, AIC3204_INT1CTRL,
+					 AIC3204_INT_HEADSET,
+					 data->jack ? AIC3204_INT_HEADSET : 0);
+	mutex_unlock(&data->jack_lock);
+
+	return ret;
+}
+
+/*
+ * Runs on headset insertion and removal. The sticky flags are cleared
+ * by the read but not otherwise needed, the jack state is read back on
+ * every interrupt rather than only when the flag is seen.
+ */
+static irqreturn_t pamir_ai_i2c_sound_irq(int irq, void *dev_id)
+{
+	struct pamir_ai_i2c_sound_data *data = dev_id;
+	unsigned int flags;
+	int ret;
+
+	ret = pm_runtime_resume_and_get(data->dev);
+	if (ret < 0)
+		return IRQ_NONE;
+
+	mutex_lock(&data->jack_lock);
+	ret = regmap_read(data->regmap, AIC3204_STICKYFLAG2, &flags);
+	if (!ret)
+		ret = pamir_ai_i2c_sound_report_jack(data);
+	mutex_unlock(&data->jack_lock);
+
+	pm_runtime_mark_last_busy(data->dev);
+	pm_runtime_put_autosuspend(data->dev);
+
+	if (ret < 0) {
+		dev_err(data->dev, "Failed to read headset status: %d\n", ret);
+		return IRQ_NONE;
+	}
+
+	return IRQ_HANDLED;
+}
+
+/**
+ * pamir_ai_i2c_sound_set_jack - attach a jack to headset detection
+ * @component: codec component
+ * @jack: jack to report to, NULL to stop reporting
+ * @unused: unused
+ *
+ * Detection needs the codec's interrupt line, so without an "interrupts"
+ * property the machine driver is told it is not supported.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_set_jack(struct snd_soc_component *component,
+				       struct snd_soc_jack *jack, void *unused)
+{
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(component);
+	int ret;
+
+	if (data->client->irq <= 0)
+		return jack ? -ENOTSUPP : 0;
+
+	ret = pm_runtime_resume_and_get(data->dev);
+	if (ret < 0)
+		return ret;
+
+	mutex_lock(&data->jack_lock);
+	data->jack = jack;
+	mutex_unlock(&data->jack_lock);
+
+	ret = pamir_ai_i2c_sound_init_jack(data);
+
+	pm_runtime_mark_last_busy(data->dev);
+	pm_runtime_put_autosuspend(data->dev);
+	return ret;
+}
+
+static int pamir_ai_i2c_sound_component_probe(struct snd_soc_component *component)
+{
+	struct snd_soc_dapm_context *dapm =
+		snd_soc_component_get_dapm(component);
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(component);
+	struct snd_kcontrol_new dsp_profile =
+		SOC_ENUM_EXT("DSP Profile", data->dsp_enum,
+			     pamir_ai_dsp_profile_get,
+			     pamir_ai_dsp_profile_put);
+	int ret;
+
+	/* Only offered when there is something besides "Flat" to pick */
+	if (data->dsp_enum.items > 1) {
+		ret = snd_soc_add_component_controls(component, &dsp_profile, 1);
+		if (ret < 0)
+			return ret;
+	}
+
+	if (!device_property_read_bool(component->dev, "pamir-ai,mic-bias"))
+		return 0;
+
+	return snd_soc_dapm_add_routes(dapm, pamir_ai_micbias_routes,
+				       ARRAY_SIZE(pamir_ai_micbias_routes));
+}
+
+/* The jack belongs to the card, which is going away */
+static void pamir_ai_i2c_sound_component_remove(struct snd_soc_component *component)
+{
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(component);
+
+	mutex_lock(&data->jack_lock);
+	data->jack = NULL;
+	mutex_unlock(&data->jack_lock);
+}
+
+/**
+ * struct pamir_ai_clk_div - codec clock tree settings for one sample rate
+ * @mclk: codec MCLK input frequency
+ * @rate: sample rate
+ * @pll_p: PLL P divider (1-8)
+ * @pll_r: PLL R multiplier (1-16)
+ * @pll_j: PLL J multiplier (1-63), 0 clocks the codec from MCLK directly
+ * @pll_d: PLL D fractional multiplier (0-9999)
+ * @ndac: NDAC divider (1-128)
+ * @mdac: MDAC divider (1-128)
+ * @dosr: DAC oversampling ratio
+ * @nadc: NADC divider (1-128)
+ * @madc: MADC divider (1-128)
+ * @aosr: ADC oversampling ratio
+ *
+ * CODEC_CLKIN is either MCLK or mclk * pll_r * pll_j.pll_d / pll_p, and
+ * fs = CODEC_CLKIN / (ndac * mdac * dosr) = CODEC_CLKIN / (nadc * madc * aosr)
+ *
+ * DOSR is picked per rate so that DAC_MOD_CLK (dosr * fs) stays within
+ * the 2.8-6.2 MHz the DAC interpolation filters are specified for.
+ * mdac * dosr and madc * aosr must leave 32 times the resource class of
+ * the processing blocks, see PAMIR_AI_DAC_RC and PAMIR_AI_ADC_RC, which
+ * rules out running 96 kHz straight from a 12.288/24.576 MHz MCLK.
+ */
+struct pamir_ai_clk_div {
+	u32 mclk;
+	u32 rate;
+	u8 pll_p;
+	u8 pll_r;
+	u8 pll_j;
+	u16 pll_d;
+	u8 ndac;
+	u8 mdac;
+	u16 dosr;
+	u8 nadc;
+	u8 madc;
+	u16 aosr;
+};
+
+static const struct pamir_ai_clk_div pamir_ai_clk_divs[] = {
+	/* mclk, rate, p, r, j, d, ndac, mdac, dosr, nadc, madc, aosr */
+
+	/* 12.288 MHz MCLK, PLL at 90.3168 MHz or 98.304 MHz above 48 kHz */
+	{ 12288000, 8000, 0, 0, 0, 0, 1, 2, 768, 1, 12, 128 },
+	{ 12288000, 11025, 1, 1, 7, 3500, 2, 8, 512, 2, 32, 128 },
+	{ 12288000, 16000, 0, 0, 0, 0, 1, 2, 384, 1, 6, 128 },
+	{ 12288000, 22050, 1, 1, 7, 3500, 2, 8, 256, 2, 16, 128 },
+	{ 12288000, 32000, 0, 0, 0, 0, 1, 3, 128, 1, 3, 128 },
+	{ 12288000, 44100, 1, 1, 7, 3500, 2, 8, 128, 2, 8, 128 },
+	{ 12288000, 48000, 0, 0, 0, 0, 1, 2, 128, 1, 2, 128 },
+	{ 12288000, 88200, 1, 1, 7, 3500, 2, 8, 64, 2, 8, 64 },
+	{ 12288000, 96000, 1, 1, 8, 0, 2, 8, 64, 2, 8, 64 },
+
+	/* 24.576 MHz MCLK, PLL at 90.3168 MHz or 98.304 MHz above 48 kHz */
+	{ 24576000, 8000, 0, 0, 0, 0, 2, 2, 768, 2, 12, 128 },
+	{ 24576000, 11025, 2, 1, 7, 3500, 2, 8, 512, 2, 32, 128 },
+	{ 24576000, 16000, 0, 0, 0, 0, 2, 2, 384, 2, 6, 128 },
+	{ 24576000, 22050, 2, 1, 7, 3500, 2, 8, 256, 2, 16, 128 },
+	{ 24576000, 32000, 0, 0, 0, 0, 2, 3, 128, 2, 3, 128 },
+	{ 24576000, 44100, 2, 1, 7, 3500, 2, 8, 128, 2, 8, 128 },
+	{ 24576000, 48000, 0, 0, 0, 0, 2, 2, 128, 2, 2, 128 },
+	{ 24576000, 88200, 2, 1, 7, 3500, 2, 8, 64, 2, 8, 64 },
+	{ 24576000, 96000, 2, 1, 8, 0, 2, 8, 64, 2, 8, 64 },
+
+	/* 12 MHz MCLK, PLL at 98.304 MHz or 90.3168 MHz */
+	{ 12000000, 8000, 1, 1, 8, 1920, 2, 8, 768, 2, 48, 128 },
+	{ 12000000, 11025, 1, 1, 7, 5264, 2, 8, 512, 2, 32, 128 },
+	{ 12000000, 16000, 1, 1, 8, 1920, 2, 8, 384, 2, 24, 128 },
+	{ 12000000, 22050, 1, 1, 7, 5264, 2, 8, 256, 2, 16, 128 },
+	{ 12000000, 32000, 1, 1, 8, 1920, 2, 12, 128, 2, 12, 128 },
+	{ 12000000, 44100, 1, 1, 7, 5264, 2, 8, 128, 2, 8, 128 },
+	{ 12000000, 48000, 1, 1, 8, 1920, 2, 8, 128, 2, 8, 128 },
+	{ 12000000, 88200, 1, 1, 7, 5264, 2, 8, 64, 2, 8, 64 },
+	{ 12000000, 96000, 1, 1, 8, 1920, 2, 8, 64, 2, 8, 64 },
+};
+
+static const struct pamir_ai_clk_div *pamir_ai_i2c_sound_get_clk_div(u32 mclk,
+								     u32 rate)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(pamir_ai_clk_divs); i++)
+		if (pamir_ai_clk_divs[i].mclk == mclk &&
+		    pamir_ai_clk_divs[i].rate == rate)
+			return &pamir_ai_clk_divs[i];
+
+	return NULL;
+}
+
+/**
+ * pamir_ai_i2c_sound_set_clocks - program the codec clock tree
+ * @data: private data structure
+ * @div: clock settings for the new rate
+ *
+ * The DAC and ADC dividers are stopped while the clock source and PLL
+ * are changed, and restarted once the PLL had time to lock. In low
+ * latency mode the lower-delay processing blocks and oversampling
+ * ratios are selected when the rate allows it, and the group delay
+ * recorded is the one of the blocks actually programmed.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_set_clocks(struct pamir_ai_i2c_sound_data *data,
+					 const struct pamir_ai_clk_div *div)
+{
+	unsigned int dac_prod = div->mdac * div->dosr;
+	unsigned int adc_prod = div->madc * div->aosr;
+	u8 pll[4], dac_div[4], adc_div[3], prb[2];
+	u8 mdac = div->mdac, madc = div->madc;
+	u16 dosr = div->dosr, aosr = div->aosr;
+	u8 dac_delay = PAMIR_AI_DAC_DELAY, adc_delay = PAMIR_AI_ADC_DELAY;
+	int ret;
+
+	if (dac_prod < 32 * PAMIR_AI_DAC_RC ||
+	    adc_prod < 32 * PAMIR_AI_ADC_RC) {
+		dev_err(data->dev, "Clock settings for %u Hz starve the processing blocks\n",
+			div->rate);
+		return -EINVAL;
+	}
+
+	prb[0] = PAMIR_AI_DAC_PRB;
+	prb[1] = PAMIR_AI_ADC_PRB;
+
+	/*
+	 * Low latency keeps MDAC * DOSR (and MADC * AOSR) constant and moves
+	 * to the lower oversampling ratio, as long as the divider still fits.
+	 * The DAC only switches at rates where DOSR 32 keeps DAC_MOD_CLK in
+	 * range, i.e. 88.2 and 96 kHz.
+	 */
+	if (data->low_latency &&
+	    PAMIR_AI_DAC_DOSR_LL * div->rate >= PAMIR_AI_DAC_MOD_CLK_MIN &&
+	    !(dac_prod % PAMIR_AI_DAC_DOSR_LL) &&
+	    dac_prod / PAMIR_AI_DAC_DOSR_LL <= AIC3204_PAGE_SIZE) {
+		mdac = dac_prod / PAMIR_AI_DAC_DOSR_LL;
+		dosr = PAMIR_AI_DAC_DOSR_LL;
+		prb[0] = PAMIR_AI_DAC_PRB_LL;
+		dac_delay = PAMIR_AI_DAC_DELAY_LL;
+	}
+
+	if (data->low_latency && !(adc_prod % PAMIR_AI_ADC_AOSR_LL) &&
+	    adc_prod / PAMIR_AI_ADC_AOSR_LL <= AIC3204_PAGE_SIZE) {
+		madc = adc_prod / PAMIR_AI_ADC_AOSR_LL;
+		aosr = PAMIR_AI_ADC_AOSR_LL;
+		prb[1] = PAMIR_AI_ADC_PRB_LL;
+		adc_delay = PAMIR_AI_ADC_DELAY_LL;
+	}
+
+	/* Force a full reprogram next time if anything below fails */
+	data->clk_div = NULL;
+
+	ret = pamir_ai_i2c_update_bits(data, PAMIR_AI_OP_CLOCKS, AIC3204_NDAC,
+				       AIC3204_DIV_POWER, 0);
+	if (ret < 0)
+		return ret;
+
+	ret = pamir_ai_i2c_update_bits(data, PAMIR_AI_OP_CLOCKS, AIC3204_NADC,
+				       AIC3204_DIV_POWER, 0);
+	if (ret < 0)
+		return ret;
+
+	if (div->pll_j) {
+		ret = pamir_ai_i2c_update_bits(data, PAMIR_AI_OP_CLOCKS,
+					       AIC3204_CLKMUX,
+					       AIC3204_PLL_CLKIN_MASK |
+					       AIC3204_CODEC_CLKIN_MASK,
+					       AIC3204_PLL_CLKIN_MCLK |
+					       AIC3204_CODEC_CLKIN_PLL);
+		if (ret < 0)
+			return ret;
+
+		/* P/R, J, D MSB and D LSB are consecutive registers */
+		pll[0] = AIC3204_PLL_POWER | ((div->pll_p & 0x07) << 4) |
+			 (div->pll_r & 0x0f);
+		pll[1] = div->pll_j;
+		pll[2] = div->pll_d >> 8;
+		pll[3] = div->pll_d & 0xff;
+		ret = pamir_ai_i2c_bulk_write(data, PAMIR_AI_OP_CLOCKS,
+					      AIC3204_PLLPR, pll,
+					      ARRAY_SIZE(pll));
+		if (ret < 0)
+			return ret;
+
+		fsleep(PAMIR_AI_PLL_LOCK_US);
+	} else {
+		ret = pamir_ai_i2c_update_bits(data, PAMIR_AI_OP_CLOCKS,
+					       AIC3204_CLKMUX,
+					       AIC3204_CODEC_CLKIN_MASK,
+					       AIC3204_CODEC_CLKIN_MCLK);
+		if (ret < 0)
+			return ret;
+
+		ret = pamir_ai_i2c_update_bits(data, PAMIR_AI_OP_CLOCKS,
+					       AIC3204_PLLPR, AIC3204_PLL_POWER,
+					       0);
+		if (ret < 0)
+			return ret;
+	}
+
+	/* NDAC, MDAC, DOSR MSB and LSB are consecutive registers */
+	dac_div[0] = AIC3204_DIV_POWER | (div->ndac & AIC3204_DIV_MASK);
+	dac_div[1] = AIC3204_DIV_POWER | (mdac & AIC3204_DIV_MASK);
+	dac_div[2] = (dosr >> 8) & 0x03;
+	dac_div[3] = dosr & 0xff;
+	ret = pamir_ai_i2c_bulk_write(data, PAMIR_AI_OP_CLOCKS, AIC3204_NDAC,
+				      dac_div, ARRAY_SIZE(dac_div));
+	if (ret < 0)
+		return ret;
+
+	/* NADC, MADC and AOSR are consecutive registers */
+	adc_div[0] = AIC3204_DIV_POWER | (div->nadc & AIC3204_DIV_MASK);
+	adc_div[1] = AIC3204_DIV_POWER | (madc & AIC3204_DIV_MASK);
+	adc_div[2] = aosr & 0xff;
+	ret = pamir_ai_i2c_bulk_write(data, PAMIR_AI_OP_CLOCKS, AIC3204_NADC,
+				      adc_div, ARRAY_SIZE(adc_div));
+	if (ret < 0)
+		return ret;
+
+	/* DAC and ADC processing block selections are consecutive */
+	ret = pamir_ai_i2c_bulk_write(data, PAMIR_AI_OP_CLOCKS, AIC3204_DACPRB,
+				      prb, ARRAY_SIZE(prb));
+	if (ret < 0)
+		return ret;
+
+	data->clk_div = div;
+	data->clk_low_latency = data->low_latency;
+	data->dosr = dosr;
+	data->dac_delay = dac_delay;
+	data->adc_delay = adc_delay;
+	return 0;
+}
+
+/**
+ * pamir_ai_i2c_sound_set_bclk - program the BCLK divider in provider mode
+ * @data: private data structure
+ * @frame_bits: BCLK cycles per frame
+ *
+ * BCLK is divided from DAC_CLK (fs * MDAC * DOSR), or from DAC_MOD_CLK
+ * (fs * DOSR) when the divider would not fit, so that it tracks the
+ * programmed rate exactly. WCLK follows DAC_FS, the reset default.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_set_bclk(struct pamir_ai_i2c_sound_data *data,
+				       unsigned int frame_bits)
+{
+	unsigned int ratio = data->clk_div->mdac * data->clk_div->dosr;
+	unsigned int clkin = AIC3204_BDIV_CLKIN_DAC_CLK;
+	int ret;
+
+	if (ratio / frame_bits > AIC3204_PAGE_SIZE) {
+		ratio = data->dosr;
+		clkin = AIC3204_BDIV_CLKIN_DAC_MOD_CLK;
+	}
+
+	if (!frame_bits || ratio % frame_bits ||
+	    ratio / frame_bits > AIC3204_PAGE_SIZE) {
+		dev_err(data->dev, "Cannot divide BCLK for %u bit frames at %u Hz\n",
+			frame_bits, data->clk_div->rate);
+		return -EINVAL;
+	}
+
+	ret = pamir_ai_i2c_update_bits(data, PAMIR_AI_OP_CLOCKS, AIC3204_IFACE2,
+				       AIC3204_BDIV_CLKIN_MASK, clkin);
+	if (ret < 0)
+		return ret;
+
+	return pamir_ai_i2c_write(data, PAMIR_AI_OP_CLOCKS, AIC3204_BCLKN,
+				  AIC3204_DIV_POWER |
+				  ((ratio / frame_bits) & AIC3204_DIV_MASK));
+}
+
+#define PAMIR_AI_RATES (SNDRV_PCM_RATE_8000 | SNDRV_PCM_RATE_11025 | \
+			SNDRV_PCM_RATE_16000 | SNDRV_PCM_RATE_22050 | \
+			SNDRV_PCM_RATE_32000 | SNDRV_PCM_RATE_44100 | \
+			SNDRV_PCM_RATE_48000 | SNDRV_PCM_RATE_88200 | \
+			SNDRV_PCM_RATE_96000)
+#define PAMIR_AI_FORMATS (SNDRV_PCM_FMTBIT_S16_LE | SNDRV_PCM_FMTBIT_S24_LE | \
+			  SNDRV_PCM_FMTBIT_S32_LE)
+
+/**
+ * pamir_ai_i2c_sound_init_rates - collect the rates reachable from MCLK
+ * @data: private data structure
+ *
+ * Only the clock table entries for the actual MCLK frequency can be
+ * programmed in hw_params, so streams are restricted to those rates
+ * up front instead of failing once the application committed to one.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_init_rates(struct pamir_ai_i2c_sound_data *data)
+{
+	unsigned int count = 0;
+	int i;
+
+	data->rates = devm_kcalloc(data->dev, ARRAY_SIZE(pamir_ai_clk_divs),
+				   sizeof(*data->rates), GFP_KERNEL);
+	if (!data->rates)
+		return -ENOMEM;
+
+	for (i = 0; i < ARRAY_SIZE(pamir_ai_clk_divs); i++)
+		if (pamir_ai_clk_divs[i].mclk == data->mclk_rate)
+			data->rates[count++] = pamir_ai_clk_divs[i].rate;
+
+	if (!count)
+		dev_warn(data->dev, "No sample rates available with %lu Hz MCLK\n",
+			 data->mclk_rate);
+
+	data->rate_constraint.count = count;
+	data->rate_constraint.list = data->rates;
+	return 0;
+}
+
+/**
+ * pamir_ai_i2c_sound_startup - restrict the stream to what the link carries
+ * @substream: PCM substream
+ * @dai: codec DAI
+ *
+ * Limits the rate to the clock table entries for the current MCLK and
+ * the sample width to what fits in a slot, as set up through TDM or a
+ * fixed BCLK ratio. More than two channels are only carried in TDM mode,
+ * where the codec uses two of the slots.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_startup(struct snd_pcm_substream *substream,
+				      struct snd_soc_dai *dai)
+{
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(dai->component);
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	unsigned int max_width = 32, channels = 2;
+	u64 formats = PAMIR_AI_FORMATS;
+	int ret;
+
+	if (!data->rate_constraint.count) {
+		dev_err(data->dev, "No sample rates available with %lu Hz MCLK\n",
+			data->mclk_rate);
+		return -EINVAL;
+	}
+
+	ret = snd_pcm_hw_constraint_list(runtime, 0, SNDRV_PCM_HW_PARAM_RATE,
+					 &data->rate_constraint);
+	if (ret < 0)
+		return ret;
+
+	if (data->tdm_slots) {
+		max_width = data->tdm_width;
+		channels = data->tdm_slots;
+	} else if (data->bclk_ratio) {
+		if (data->bclk_ratio < 32) {
+			dev_err(data->dev, "BCLK ratio %u too small for stereo\n",
+				data->bclk_ratio);
+			return -EINVAL;
+		}
+		max_width = min(data->bclk_ratio / 2, 32U);
+	}
+
+	if (max_width < 32)
+		formats &= ~SNDRV_PCM_FMTBIT_S32_LE;
+	if (max_width < 24)
+		formats &= ~SNDRV_PCM_FMTBIT_S24_LE;
+
+	ret = snd_pcm_hw_constraint_mask64(runtime, SNDRV_PCM_HW_PARAM_FORMAT,
+					   formats);
+	if (ret < 0)
+		return ret;
+
+	return snd_pcm_hw_constraint_minmax(runtime, SNDRV_PCM_HW_PARAM_CHANNELS,
+					    2, channels);
+}
+
+static int pamir_ai_i2c_sound_set_bclk_ratio(struct snd_soc_dai *dai,
+					     unsigned int ratio)
+{
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(dai->component);
+
+	data->bclk_ratio = ratio;
+	return 0;
+}
+
+static int pamir_ai_i2c_sound_word_len(unsigned int width, unsigned int *wlen)
+{
+	switch (width) {
+	case 16:
+		*wlen = AIC3204_WORD_LEN_16;
+		break;
+	case 20:
+		*wlen = AIC3204_WORD_LEN_20;
+		break;
+	case 24:
+		*wlen = AIC3204_WORD_LEN_24;
+		break;
+	case 32:
+		*wlen = AIC3204_WORD_LEN_32;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * pamir_ai_i2c_sound_set_tdm_slot - place the codec in a TDM frame
+ * @dai: codec DAI
+ * @tx_mask: slots the ADC data is sent in
+ * @rx_mask: slots the DAC data is taken from
+ * @slots: number of slots per frame, 0 to leave TDM mode
+ * @slot_width: slot width in bits
+ *
+ * The codec carries its two channels back to back from a single data
+ * offset shared by DIN and DOUT, so both masks must select the same two
+ * adjacent slots. DOUT is released outside of them so other devices on
+ * the bus can drive the remaining slots.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_set_tdm_slot(struct snd_soc_dai *dai,
+					   unsigned int tx_mask,
+					   unsigned int rx_mask,
+					   int slots, int slot_width)
+{
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(dai->component);
+	unsigned int mask = tx_mask | rx_mask;
+	unsigned int first, wlen;
+
+	if (!slots) {
+		data->tdm_slots = 0;
+		data->tdm_offset = 0;
+		return 0;
+	}
+
+	if (slots < 2 || slots > PAMIR_AI_MAX_TDM_SLOTS ||
+	    pamir_ai_i2c_sound_word_len(slot_width, &wlen) < 0) {
+		dev_err(data->dev, "Unsupported TDM setup: %d slots of %d bits\n",
+			slots, slot_width);
+		return -EINVAL;
+	}
+
+	first = mask ? __ffs(mask) : 0;
+	if ((tx_mask && tx_mask != rx_mask && rx_mask) ||
+	    (mask && mask != 0x3U << first) || first + 2 > slots ||
+	    first * slot_width > U8_MAX) {
+		dev_err(data->dev, "Unsupported TDM slot masks %#x/%#x\n",
+			tx_mask, rx_mask);
+		return -EINVAL;
+	}
+
+	data->tdm_slots = slots;
+	data->tdm_width = slot_width;
+	data->tdm_offset = first * slot_width;
+	return 0;
+}
+
+static int pamir_ai_i2c_sound_trigger(struct snd_pcm_substream *substream,
+				      int cmd, struct snd_soc_dai *dai)
+{
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(dai->component);
+
+	/* Atomic context, keep this to a tracepoint */
+	trace_pamir_ai_trigger(data->client, substream->stream, cmd);
+	return 0;
+}
+
+/**
+ * pamir_ai_i2c_sound_hw_params - program the codec for the stream rate
+ * @substream: PCM substream
+ * @params: hardware parameters
+ * @dai: codec DAI
+ *
+ * Reprograms the PLL, the DAC and ADC clock dividers and oversampling
+ * ratios for the requested rate and sets the audio interface word length.
+ * As clock provider the codec also divides BCLK down for the frame.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_hw_params(struct snd_pcm_substream *substream,
+					struct snd_pcm_hw_params *params,
+					struct snd_soc_dai *dai)
+{
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(dai->component);
+	const struct pamir_ai_clk_div *div;
+	unsigned int width = params_width(params);
+	unsigned int wlen, frame_bits, iface1 = 0;
+	u8 offset = data->fmt_offset;
+	int ret;
+
+	div = pamir_ai_i2c_sound_get_clk_div(data->mclk_rate,
+					     params_rate(params));
+	if (!div) {
+		dev_err(data->dev, "Unsupported rate %u Hz with %lu Hz MCLK\n",
+			params_rate(params), data->mclk_rate);
+		return -EINVAL;
+	}
+
+	/*
+	 * In TDM mode the codec reads whole slots, with the sample left
+	 * justified and zero padded, and never drives DOUT outside its own.
+	 */
+	if (data->tdm_slots) {
+		if (width > data->tdm_width) {
+			dev_err(data->dev, "Width %u exceeds %u bit TDM slots\n",
+				width, data->tdm_width);
+			return -EINVAL;
+		}
+		width = data->tdm_width;
+		offset += data->tdm_offset;
+		iface1 |= AIC3204_IFACE1_DOUT_HIZ;
+	} else if (params_channels(params) != 2) {
+		dev_err(data->dev, "%u channels need TDM mode\n",
+			params_channels(params));
+		return -EINVAL;
+	}
+
+	if (pamir_ai_i2c_sound_word_len(width, &wlen) < 0) {
+		dev_err(data->dev, "Unsupported width %u\n", width);
+		return -EINVAL;
+	}
+
+	/* The other direction may already be running at this rate */
+	if (div != data->clk_div ||
+	    data->low_latency != data->clk_low_latency) {
+		ret = pamir_ai_i2c_sound_set_clocks(data, div);
+		if (ret < 0)
+			return ret;
+	}
+
+	if (data->clk_provider) {
+		if (data->tdm_slots)
+			frame_bits = data->tdm_slots * data->tdm_width;
+		else if (data->bclk_ratio)
+			frame_bits = data->bclk_ratio;
+		else
+			frame_bits = width <= 16 ? 32 : 64;
+
+		ret = pamir_ai_i2c_sound_set_bclk(data, frame_bits);
+		if (ret < 0)
+			return ret;
+	}
+
+	ret = pamir_ai_i2c_write(data, PAMIR_AI_OP_CLOCKS, AIC3204_DATAOFFSET,
+				 offset);
+	if (ret < 0)
+		return ret;
+
+	return pamir_ai_i2c_update_bits(data, PAMIR_AI_OP_CLOCKS,
+					AIC3204_IFACE1, AIC3204_WORD_LEN_MASK |
+					AIC3204_IFACE1_DOUT_HIZ, wlen | iface1);
+}
+
+static int pamir_ai_i2c_sound_set_fmt(struct snd_soc_dai *dai,
+				      unsigned int fmt)
+{
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(dai->component);
+	u8 iface1 = 0, iface2 = 0, offset = 0;
+	int ret;
+
+	switch (fmt & SND_SOC_DAIFMT_CLOCK_PROVIDER_MASK) {
+	case SND_SOC_DAIFMT_CBC_CFC:
+		break;
+	case SND_SOC_DAIFMT_CBP_CFP:
+		iface1 |= AIC3204_IFACE1_BCLK_OUT | AIC3204_IFACE1_WCLK_OUT;
+		break;
+	default:
+		dev_err(data->dev, "Unsupported clock provider mode\n");
+		return -EINVAL;
+	}
+
+	switch (fmt & SND_SOC_DAIFMT_FORMAT_MASK) {
+	case SND_SOC_DAIFMT_I2S:
+		iface1 |= AIC3204_IFACE1_I2S;
+		break;
+	case SND_SOC_DAIFMT_DSP_A:
+		iface1 |= AIC3204_IFACE1_DSP;
+		iface2 |= AIC3204_BCLK_INV;
+		offset = 1;
+		break;
+	case SND_SOC_DAIFMT_DSP_B:
+		iface1 |= AIC3204_IFACE1_DSP;
+		iface2 |= AIC3204_BCLK_INV;
+		break;
+	case SND_SOC_DAIFMT_RIGHT_J:
+		iface1 |= AIC3204_IFACE1_RJF;
+		break;
+	case SND_SOC_DAIFMT_LEFT_J:
+		iface1 |= AIC3204_IFACE1_LJF;
+		break;
+	default:
+		dev_err(data->dev, "Unsupported DAI format\n");
+		return -EINVAL;
+	}
+
+	switch (fmt & SND_SOC_DAIFMT_INV_MASK) {
+	case SND_SOC_DAIFMT_NB_NF:
+		break;
+	case SND_SOC_DAIFMT_IB_NF:
+		iface2 ^= AIC3204_BCLK_INV;
+		break;
+	default:
+		dev_err(data->dev, "Unsupported clock inversion\n");
+		return -EINVAL;
+	}
+
+	ret = pamir_ai_i2c_update_bits(data, PAMIR_AI_OP_CLOCKS, AIC3204_IFACE1,
+				       AIC3204_IFACE1_MODE_MASK |
+				       AIC3204_IFACE1_BCLK_OUT |
+				       AIC3204_IFACE1_WCLK_OUT, iface1);
+	if (ret < 0)
+		return ret;
+
+	/* Applied together with the TDM slot offset in hw_params */
+	data->fmt_offset = offset;
+	data->clk_provider = !!(iface1 & AIC3204_IFACE1_BCLK_OUT);
+
+	return pamir_ai_i2c_update_bits(data, PAMIR_AI_OP_CLOCKS,
+					AIC3204_IFACE2, AIC3204_BCLK_INV,
+					iface2);
+}
+
+/* Report the codec filter group delay as part of the PCM delay */
+static snd_pcm_sframes_t pamir_ai_i2c_sound_delay(struct snd_pcm_substream *substream,
+						  struct snd_soc_dai *dai)
+{
+	struct pamir_ai_i2c_sound_data *data =
+		snd_soc_component_get_drvdata(dai->component);
+
+	return substream->stream == SNDRV_PCM_STREAM_PLAYBACK ?
+	       data->dac_delay : data->adc_delay;
+}
+
+static const struct snd_soc_dai_ops pamir_ai_i2c_sound_dai_ops = {
+	.startup = pamir_ai_i2c_sound_startup,
+	.trigger = pamir_ai_i2c_sound_trigger,
+	.delay = pamir_ai_i2c_sound_delay,
+	.hw_params = pamir_ai_i2c_sound_hw_params,
+	.set_fmt = pamir_ai_i2c_sound_set_fmt,
+	.set_bclk_ratio = pamir_ai_i2c_sound_set_bclk_ratio,
+	.set_tdm_slot = pamir_ai_i2c_sound_set_tdm_slot,
+};
+
+static struct snd_soc_dai_driver pamir_ai_i2c_sound_dai = {
+	.name = "pamir-ai-hifi",
+	.capture = { .stream_name = "HiFi Capture",
+		.channels_min = 2,
+		.channels_max = PAMIR_AI_MAX_TDM_SLOTS,
+		.rates = PAMIR_AI_RATES,
+		.formats = PAMIR_AI_FORMATS },
+	.playback = { .stream_name = "HiFi Playback",
+		.channels_min = 2,
+		.channels_max = PAMIR_AI_MAX_TDM_SLOTS,
+		.rates = PAMIR_AI_RATES,
+		.formats = PAMIR_AI_FORMATS },
+	.ops = &pamir_ai_i2c_sound_dai_ops,
+	.symmetric_rate = 1,
+};
+
+static const struct snd_soc_component_driver pamir_ai_i2c_sound_component = {
+	.probe = pamir_ai_i2c_sound_component_probe,
+	.remove = pamir_ai_i2c_sound_component_remove,
+	.set_jack = pamir_ai_i2c_sound_set_jack,
+	.controls = pamir_ai_snd_controls,
+	.num_controls = ARRAY_SIZE(pamir_ai_snd_controls),
+	.dapm_widgets = pamir_ai_dapm_widgets,
+	.num_dapm_widgets = ARRAY_SIZE(pamir_ai_dapm_widgets),
+	.dapm_routes = pamir_ai_dapm_routes,
+	.num_dapm_routes = ARRAY_SIZE(pamir_ai_dapm_routes),
+	.use_pmdown_time = 1,
+	.endianness = 1,
+};
+
+static void pamir_ai_i2c_sound_disable_mclk(void *arg)
+{
+	struct pamir_ai_i2c_sound_data *data = arg;
+
+	if (!pm_runtime_status_suspended(data->dev))
+		clk_disable_unprepare(data->mclk);
+}
+
+/* Clock tree enables gated while the codec is runtime suspended, bit 7 of each */
+static const unsigned int pamir_ai_i2c_sound_clk_regs[] = {
+	AIC3204_PLLPR,
+	AIC3204_NDAC,
+	AIC3204_MDAC,
+	AIC3204_NADC,
+	AIC3204_MADC,
+	AIC3204_CLKOUTM,
+	AIC3204_BCLKN,
+};
+
+/**
+ * pamir_ai_i2c_sound_runtime_suspend - put the codec into low-power mode
+ * @dev: device structure
+ *
+ * DAPM has already powered down the analog blocks by the time the codec
+ * goes idle, so only the clock dividers are left running. They are
+ * stopped behind the cache's back, so the cache still holds the running
+ * configuration for resume. With a reset line and no jack to watch the
+ * codec is held in reset as well.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_runtime_suspend(struct device *dev)
+{
+	struct pamir_ai_i2c_sound_data *data = dev_get_drvdata(dev);
+	int i, ret = 0;
+
+	regcache_cache_bypass(data->regmap, true);
+	for (i = 0; i < ARRAY_SIZE(pamir_ai_i2c_sound_clk_regs) && !ret; i++)
+		ret = regmap_update_bits(data->regmap,
+					 pamir_ai_i2c_sound_clk_regs[i],
+					 AIC3204_DIV_POWER, 0);
+	regcache_cache_bypass(data->regmap, false);
+	if (ret < 0) {
+		dev_err(dev, "Failed to stop codec clocks: %d\n", ret);
+		return ret;
+	}
+
+	regcache_cache_only(data->regmap, true);
+	clk_disable_unprepare(data->mclk);
+
+	/* Headset detection keeps running while idle */
+	mutex_lock(&data->jack_lock);
+	data->in_reset = data->reset_gpio && !data->jack;
+	mutex_unlock(&data->jack_lock);
+	if (data->in_reset)
+		gpiod_set_value_cansleep(data->reset_gpio, 1);
+
+	return 0;
+}
+
+/**
+ * pamir_ai_i2c_sound_runtime_resume - restore the codec from the cache
+ * @dev: device structure
+ *
+ * The codec is reset, by releasing its reset line if it was held or via
+ * the software reset otherwise, so that it is at its power-on defaults
+ * whether or not the rail dropped. The cache is then marked dirty and
+ * regcache_sync() rewrites only the registers that differ from those
+ * defaults instead of replaying init_sequence.
+ *
+ * A codec with headset detection armed was left running through suspend
+ * with only its clocks stopped. It is not reset, which would restart
+ * detection and report the jack unplugged until the debounce expires.
+ * The clock registers are written back from the cache, and since the
+ * cache was not marked dirty, regcache_sync() sends every write cached
+ * while suspended, including those back to a power-on default.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int pamir_ai_i2c_sound_runtime_resume(struct device *dev)
+{
+	struct pamir_ai_i2c_sound_data *data = dev_get_drvdata(dev);
+	unsigned int val;
+	bool armed;
+	int i, ret;
+
+	ret = clk_prepare_enable(data->mclk);
+	if (ret < 0) {
+		dev_err(dev, "Failed to enable MCLK: %d\n", ret);
+		return ret;
+	}
+
+	regcache_cache_only(data->regmap, false);
+
+	mutex_lock(&data->jack_lock);
+	armed = data->jack;
+	mutex_unlock(&data->jack_lock);
+
+	if (data->in_reset) {
+		gpiod_set_value_cansleep(data->reset_gpio, 0);
+		data->in_reset = false;
+		fsleep(PAMIR_AI_RESET_US);
+		regcache_mark_dirty(data->regmap);
+	} else if (!armed) {
+		ret = regmap_write(data->regmap, AIC3204_RESET, 0x01);
+		if (ret < 0)
+			goto err;
+		fsleep(PAMIR_AI_RESET_US);
+		regcache_mark_dirty(data->regmap);
+	} else {
+		/* Undo runtime_suspend, PLL first */
+		for (i = 0; i < ARRAY_SIZE(pamir_ai_i2c_sound_clk_regs); i++) {
+			ret = regmap_read(data->regmap,
+					  pamir_ai_i2c_sound_clk_regs[i], &val);
+			if (!ret)
+				ret = regmap_write(data->regmap,
+						   pamir_ai_i2c_sound_clk_regs[i],
+						   val);
+			if (ret < 0)
+				goto err;
+		}
+	}
+
+	ret = regcache_sync(data->regmap);
+	if (ret < 0)
+		goto err;
+
+	/* The coefficient RAM and buffer state survive without a reset */
+	if (!armed) {
+		ret = pamir_ai_i2c_sound_init_coefs(data);
+		if (ret < 0)
+			goto err;
+	}
+
+	if (data->clk_div && data->clk_div->pll_j)
+		fsleep(PAMIR_AI_PLL_LOCK_US);
+
+	return 0;
+
+err:
+	dev_err(dev, "Failed to restore codec registers: %d\n", ret);
+	regcache_cache_only(data->regmap, true);
+	clk_disable_unprepare(data->mclk);
+	return ret;
+}
+
+static DEFINE_RUNTIME_DEV_PM_OPS(pamir_ai_i2c_sound_pm,
+				 pamir_ai_i2c_sound_runtime_suspend,
+				 pamir_ai_i2c_sound_runtime_resume, NULL);
+
+/* Boards with larger decoupling capacitors need a longer REF charge */
+static int pamir_ai_i2c_sound_set_ref_charge(struct pamir_ai_i2c_sound_data *data)
+{
+	unsigned int ms, val;
+
+	if (device_property_read_u32(data->dev, "pamir-ai,ref-charge-ms", &ms))
+		return 0;
+
+	switch (ms) {
+	case 0:
+		val = AIC3204_REF_CHARGE_SOFT;
+		break;
+	case 40:
+		val = AIC3204_REF_CHARGE_40MS;
+		break;
+	case 80:
+		val = AIC3204_REF_CHARGE_80MS;
+		break;
+	case 120:
+		val = AIC3204_REF_CHARGE_120MS;
+		break;
+	default:
+		dev_err(data->dev, "Unsupported REF charge time %u ms\n", ms);
+		return -EINVAL;
+	}
+
+	return regmap_update_bits(data->regmap, AIC3204_REFPOWERUP,
+				  AIC3204_REF_CHARGE_MASK, val);
+}
+
+/**
+ * pamir_ai_i2c_sound_init_board - apply the board's register settings
+ * @data: private data structure
+ *
+ * "pamir-ai,init-sequence" lists (page, register, value) byte triplets
+ * that are written once the built-in init sequence and the initial
+ * levels are in place, so each board variant comes up in its final
+ * state. Volatile registers are refused, they would not be restored
+ * after runtime suspend.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+VISIBLE_IF_KUNIT int
+pamir_ai_i2c_sound_init_board(struct pamir_ai_i2c_sound_data *data)
+{
+	struct reg_sequence *seq = NULL;
+	unsigned int page, reg;
+	u8 *raw;
+	int i, n, ret;
+
+	n = device_property_count_u8(data->dev, "pamir-ai,init-sequence");
+	if (n <= 0)
+		return 0;
+
+	if (n % 3) {
+		dev_err(data->dev,
+			"pamir-ai,init-sequence must hold page, register, value triplets\n");
+		return -EINVAL;
+	}
+
+	raw = kmalloc(n, GFP_KERNEL);
+	if (!raw)
+		return -ENOMEM;
+
+	ret = device_property_read_u8_array(data->dev, "pamir-ai,init-sequence",
+					    raw, n);
+	if (ret < 0)
+		goto out;
+
+	seq = kcalloc(n / 3, sizeof(*seq), GFP_KERNEL);
+	if (!seq) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < n / 3; i++) {
+		page = raw[3 * i];
+		reg = AIC3204_REG(page, raw[3 * i + 1]);
+		if (page > AIC3204_MAX_PAGE || !raw[3 * i + 1] ||
+		    raw[3 * i + 1] >= AIC3204_PAGE_SIZE ||
+		    pamir_ai_i2c_sound_volatile_reg(data->dev, reg)) {
+			dev_err(data->dev,
+				"Cannot set page %u reg 0x%02x from pamir-ai,init-sequence\n",
+				page, raw[3 * i + 1]);
+			ret = -EINVAL;
+			goto out;
+		}
+		seq[i].reg = reg;
+		seq[i].def = raw[3 * i + 2];
+	}
+
+	ret = pamir_ai_i2c_sound_write_sequence(data, seq, n / 3);
+out:
+	kfree(seq);
+	kfree(raw);
+	return ret;
+}
+EXPORT_SYMBOL_IF_KUNIT(pamir_ai_i2c_sound_init_board);
+
+static int pamir_ai_i2c_sound_probe(struct i2c_client *client)
+{
+	struct pamir_ai_i2c_sound_data *data;
+	char name[32];
+	u32 level;
+	int ret;
+
+	data = devm_kzalloc(&client->dev, sizeof(*data), GFP_KERNEL);
+	if (!data)
+		return -ENOMEM;
+
+	data->client = client;
+	data->dev = &client->dev;
+	data->volume = 50;
+	if (!device_property_read_u32(&client->dev, "pamir-ai,volume", &level))
+		data->volume = min(level, 100U);
+	data->input_gain = 50;
+	if (!device_property_read_u32(&client->dev, "pamir-ai,input-gain",
+				      &level))
+		data->input_gain = min(level, 100U);
+	data->target_volume = data->volume;
+	data->target_input_gain = data->input_gain;
+	data->access_reg = AIC3204_LDACVOL;
+	data->low_latency = device_property_read_bool(&client->dev,
+						      "pamir-ai,low-latency");
+	data->dac_delay = PAMIR_AI_DAC_DELAY;
+	data->adc_delay = PAMIR_AI_ADC_DELAY;
+	data->settle_timeout_ms = PAMIR_AI_SETTLE_TIMEOUT_MS;
+	device_property_read_u32(&client->dev, "pamir-ai,settle-timeout-ms",
+				 &data->settle_timeout_ms);
+
+	mutex_init(&data->level_lock);
+	mutex_init(&data->target_lock);
+	mutex_init(&data->dsp_lock);
+	INIT_WORK(&data->dsp_work, pamir_ai_i2c_sound_dsp_work);
+	init_completion(&data->dsp_ready);
+	mutex_init(&data->jack_lock);
+	spin_lock_init(&data->stats_lock);
+	INIT_DELAYED_WORK(&data->update_work, pamir_ai_i2c_sound_update_work);
+
+	data->regmap = devm_regmap_init_i2c(client,
+					    &pamir_ai_i2c_sound_regmap_config);
+	if (IS_ERR(data->regmap)) {
+		ret = PTR_ERR(data->regmap);
+		dev_err(&client->dev, "Failed to initialize regmap: %d\n", ret);
+		return ret;
+	}
+
+	i2c_set_clientdata(client, data);
+	dev_set_drvdata(&client->dev, data);
+
+	data->mclk = devm_clk_get_optional(&client->dev, "mclk");
+	if (IS_ERR(data->mclk))
+		return dev_err_probe(&client->dev, PTR_ERR(data->mclk),
+				     "Failed to get MCLK\n");
+	data->mclk_rate = data->mclk ? clk_get_rate(data->mclk) :
+				       PAMIR_AI_DEFAULT_MCLK_HZ;
+
+	/* Requested asserted, so the codec starts from a hardware reset */
+	data->reset_gpio = devm_gpiod_get_optional(&client->dev, "reset",
+						   GPIOD_OUT_HIGH);
+	if (IS_ERR(data->reset_gpio))
+		return dev_err_probe(&client->dev, PTR_ERR(data->reset_gpio),
+				     "Failed to get reset GPIO\n");
+	if (data->reset_gpio) {
+		fsleep(1);
+		gpiod_set_value_cansleep(data->reset_gpio, 0);
+		fsleep(PAMIR_AI_RESET_US);
+	}
+
+	ret = pamir_ai_i2c_sound_init_rates(data);
+	if (ret < 0)
+		return ret;
+
+	/* The codec stays active until probe drops its reference */
+	pm_runtime_set_autosuspend_delay(&client->dev, PAMIR_AI_AUTOSUSPEND_MS);
+	pm_runtime_use_autosuspend(&client->dev);
+	pm_runtime_set_active(&client->dev);
+	pm_runtime_get_noresume(&client->dev);
+
+	ret = clk_prepare_enable(data->mclk);
+	if (ret < 0) {
+		dev_err(&client->dev, "Failed to enable MCLK: %d\n", ret);
+		goto err_pm_put;
+	}
+
+	ret = devm_add_action_or_reset(&client->dev,
+				       pamir_ai_i2c_sound_disable_mclk, data);
+	if (ret < 0)
+		goto err_pm_put;
+
+	ret = devm_pm_runtime_enable(&client->dev);
+	if (ret < 0)
+		goto err_pm_put;
+
+	ret = pamir_ai_i2c_sound_init_codec(data);
+	if (ret < 0) {
+		dev_err(&client->dev, "Failed to initialize codec: %d\n", ret);
+		goto err_pm_put;
+	}
+	dev_dbg(&client->dev, "Initialization sequence completed\n");
+
+	ret = pamir_ai_i2c_sound_set_ref_charge(data);
+	if (ret < 0)
+		goto err_pm_put;
+
+	ret = pamir_ai_i2c_sound_init_dsp(data);
+	if (ret < 0) {
+		dev_err(&client->dev, "Failed to set up coefficient RAM: %d\n",
+			ret);
+		goto err_pm_put;
+	}
+
+	/* INT1 reports headset insertion once a jack is attached */
+	if (client->irq > 0) {
+		ret = devm_request_threaded_irq(&client->dev, client->irq, NULL,
+						pamir_ai_i2c_sound_irq,
+						IRQF_ONESHOT, "pamir-ai-i2c-sound",
+						data);
+		if (ret < 0) {
+			dev_err(&client->dev, "Failed to request IRQ %d: %d\n",
+				client->irq, ret);
+			goto err_pm_put;
+		}
+	}
+
+	/* Set initial volume and input gain */
+	ret = pamir_ai_i2c_sound_set_volume(data, data->volume);
+	if (ret < 0) {
+		dev_err(&client->dev, "Failed to set initial volume: %d\n",
+			ret);
+		goto err_pm_put;
+	}
+
+	ret = pamir_ai_i2c_sound_set_input_gain(data, data->input_gain);
+	if (ret < 0) {
+		dev_err(&client->dev, "Failed to set initial input gain: %d\n",
+			ret);
+		goto err_pm_put;
+	}
+
+	ret = pamir_ai_i2c_sound_init_board(data);
+	if (ret < 0)
+		goto err_pm_put;
+
+	/* The board settings may have moved the volume or gain registers */
+	ret = pamir_ai_i2c_sound_get_volume(data);
+	if (ret < 0)
+		goto err_pm_put;
+
+	ret = pamir_ai_i2c_sound_get_input_gain(data);
+	if (ret < 0)
+		goto err_pm_put;
+
+	data->target_volume = data->volume;
+	data->target_input_gain = data->input_gain;
+
+	ret = devm_snd_soc_register_component(&client->dev,
+					      &pamir_ai_i2c_sound_component,
+					      &pamir_ai_i2c_sound_dai, 1);
+	if (ret < 0) {
+		dev_err(&client->dev, "Failed to register component: %d\n",
+			ret);
+		goto err_pm_put;
+	}
+
+	/* Create sysfs interface */
+	ret = sysfs_create_group(&client->dev.kobj, &pamir_ai_i2c_sound_attr_group);
+	if (ret < 0) {
+		dev_err(&client->dev, "Failed to create sysfs group: %d\n",
+			ret);
+		goto err_pm_put;
+	}
+
+	snprintf(name, sizeof(name), "pamir-ai-%s", dev_name(&client->dev));
+	data->debugfs = debugfs_create_dir(name, NULL);
+	debugfs_create_file("i2c_stats", 0644, data->debugfs, data,
+			    &pamir_ai_i2c_stats_fops);
+
+	queue_work(system_wq, &data->dsp_work);
+
+	pm_runtime_mark_last_busy(&client->dev);
+	pm_runtime_put_autosuspend(&client->dev);
+
+	return 0;
+
+err_pm_put:
+	pm_runtime_put_noidle(&client->dev);
+	/*
+	 * A busy or stuck bus may recover, let the driver core try again
+	 * later. A NAK after the retries means there is no codec at this
+	 * address, which deferring would never fix.
+	 */
+	if (ret == -EAGAIN || ret == -ETIMEDOUT)
+		return dev_err_probe(&client->dev, -EPROBE_DEFER,
+				     "Codec access failed: %d\n", ret);
+	return ret;
+}
+
+static void pamir_ai_i2c_sound_remove(struct i2c_client *client)
+{
+	struct pamir_ai_i2c_sound_data *data = i2c_get_clientdata(client);
+
+	if (data) {
+		debugfs_remove_recursive(data->debugfs);
+		sysfs_remove_group(&client->dev.kobj,
+				   &pamir_ai_i2c_sound_attr_group);
+		cancel_delayed_work_sync(&data->update_work);
+		flush_work(&data->dsp_work);
+	}
 }
 
 static const struct i2c_device_id pamir_ai_i2c_sound_id[] = {
@@ -713,6 +3430,8 @@ static struct i2c_driver pamir_ai_i2c_sound_driver = {
 	.driver = {
 		.name = "pamir-ai-i2c-sound",
 		.of_match_table = pamir_ai_i2c_sound_of_match,
+		.pm = pm_ptr(&pamir_ai_i2c_sound_pm),
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = pamir_ai_i2c_sound_probe,
 	.remove = pamir_ai_i2c_sound_remove,
@@ -722,5 +3441,5 @@ static struct i2c_driver pamir_ai_i2c_sound_driver = {
 module_i2c_driver(pamir_ai_i2c_sound_driver);
 
 MODULE_AUTHOR("PamirAI, Inc");
-MODULE_DESCRIPTION("I2C driver for configuring the TLV320AIC3204 audio codec");
+MODULE_DESCRIPTION("ASoC codec driver for the TLV320AIC3204 on the Pamir AI soundcard");
 MODULE_LICENSE("GPL v2");
@@ -0,0 +1,475 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit tests for the Pamir AI soundcard codec driver.
+ *
+ * The driver's own regmap configuration, page ranges and register
+ * defaults included, runs on top of a mock I2C bus backed by a plain
+ * register file. The mock decodes page selects the way the codec does
+ * and counts every transfer, so the init sequence, the board's
+ * pamir-ai,init-sequence and the volume and input gain paths can be
+ * checked for their exact bus cost without a codec. With a bus clock
+ * set it also takes as long as a real transfer would, which gives the
+ * latency check its numbers.
+ *
+ * Copyright (C) 2025 PamirAI Incorporated - http://www.pamir.ai/
+ */
+
+#include <kunit/device.h>
+#include <kunit/test.h>
+#include <linux/delay.h>
+#include <linux/i2c.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/property.h>
+#include <linux/regmap.h>
+#include <linux/string.h>
+#include <linux/version.h>
+
+#include "pamir-ai-i2c-sound.h"
+
+/* Standard mode, the bus speed the overlay's i2c_baudrate defaults to */
+#define PAMIR_AI_TEST_BUS_HZ		100000
+
+/*
+ * Latency budgets, as i2c_stats bucket edges. A level change within a
+ * band is one 4 byte transfer, 360 us at 100 kHz. A band crossing adds
+ * the 6 byte driver gain block and a page select on either side.
+ */
+#define PAMIR_AI_TEST_LEVEL_US		512
+#define PAMIR_AI_TEST_CROSSING_US	1024
+
+/**
+ * struct pamir_ai_test - state of one test case
+ * @data: driver private data under test
+ * @adapter: I2C adapter of @client, only looked at by the tracepoints
+ * @client: I2C client of @data
+ * @regs: register file behind the mock bus, flat addressed
+ * @page: page currently selected on the mock bus
+ * @bus_hz: bus clock the mock transfers are timed at, 0 for no delay
+ * @bus_reads: read transfers on the mock bus
+ * @bus_writes: write transfers on the mock bus, page selects included
+ * @page_selects: write transfers to the page select register
+ * @regs_written: register values written, page selects excluded
+ */
+struct pamir_ai_test {
+	struct pamir_ai_i2c_sound_data data;
+	struct i2c_adapter adapter;
+	struct i2c_client client;
+	u8 regs[AIC3204_MAX_REGISTER + 1];
+	unsigned int page;
+	unsigned int bus_hz;
+	unsigned int bus_reads;
+	unsigned int bus_writes;
+	unsigned int page_selects;
+	unsigned int regs_written;
+};
+
+/* Hold the bus for as long as @bytes plus the address byte would take */
+static void pamir_ai_test_bus_delay(struct pamir_ai_test *priv, size_t bytes)
+{
+	if (priv->bus_hz)
+		udelay(DIV_ROUND_UP((bytes + 1) * 9 * USEC_PER_SEC,
+				    priv->bus_hz));
+}
+
+/* Auto-incremented access to @offset of the current page */
+static u8 *pamir_ai_test_reg(struct pamir_ai_test *priv, unsigned int offset)
+{
+	return &priv->regs[AIC3204_REG(priv->page,
+				       offset % AIC3204_PAGE_SIZE)];
+}
+
+static int pamir_ai_test_bus_write(void *context, const void *data,
+				   size_t count)
+{
+	struct pamir_ai_test *priv = context;
+	const u8 *buf = data;
+	size_t i;
+
+	if (count < 2)
+		return -EINVAL;
+
+	pamir_ai_test_bus_delay(priv, count);
+	priv->bus_writes++;
+
+	/* Offset 0 of every page is the page select register */
+	if (buf[0] == AIC3204_PSEL) {
+		priv->page = buf[1];
+		priv->page_selects++;
+		return 0;
+	}
+
+	for (i = 1; i < count; i++)
+		*pamir_ai_test_reg(priv, buf[0] + i - 1) = buf[i];
+	priv->regs_written += count - 1;
+
+	return 0;
+}
+
+static int pamir_ai_test_bus_read(void *context, const void *reg_buf,
+				  size_t reg_size, void *val_buf,
+				  size_t val_size)
+{
+	struct pamir_ai_test *priv = context;
+	unsigned int offset = *(const u8 *)reg_buf;
+	u8 *val = val_buf;
+	size_t i;
+
+	/* Register write, repeated start and the data bytes */
+	pamir_ai_test_bus_delay(priv, reg_size + 1 + val_size);
+	priv->bus_reads++;
+
+	for (i = 0; i < val_size; i++)
+		val[i] = offset + i == AIC3204_PSEL ? priv->page :
+			 *pamir_ai_test_reg(priv, offset + i);
+
+	return 0;
+}
+
+static const struct regmap_bus pamir_ai_test_bus = {
+	.write = pamir_ai_test_bus_write,
+	.read = pamir_ai_test_bus_read,
+};
+
+static int pamir_ai_test_init(struct kunit *test)
+{
+	const struct regmap_config *config = &pamir_ai_i2c_sound_regmap_config;
+	struct pamir_ai_test *priv;
+	struct device *dev;
+	unsigned int i;
+
+	priv = kunit_kzalloc(test, sizeof(*priv), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, priv);
+
+	/* Power-on state of the codec */
+	for (i = 0; i < config->num_reg_defaults; i++)
+		priv->regs[config->reg_defaults[i].reg] =
+			config->reg_defaults[i].def;
+
+	dev = kunit_device_register(test, "pamir-ai-i2c-sound-test");
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, dev);
+
+	priv->client.adapter = &priv->adapter;
+	priv->data.client = &priv->client;
+	priv->data.dev = dev;
+	priv->data.regmap = devm_regmap_init(dev, &pamir_ai_test_bus, priv,
+					     config);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, priv->data.regmap);
+	spin_lock_init(&priv->data.stats_lock);
+
+	test->priv = priv;
+	return 0;
+}
+
+/* Hand @len bytes of pamir-ai,init-sequence to the device under test */
+static void pamir_ai_test_set_board(struct kunit *test,
+				    struct pamir_ai_test *priv,
+				    const u8 *seq, size_t len)
+{
+	const struct property_entry props[] = {
+		PROPERTY_ENTRY_U8_ARRAY_LEN("pamir-ai,init-sequence", seq, len),
+		{ }
+	};
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test,
+		device_create_managed_software_node(priv->data.dev, props,
+						    NULL));
+}
+
+/* Every register access made for @op succeeded at the first attempt */
+static void pamir_ai_test_expect_clean(struct kunit *test,
+				       struct pamir_ai_i2c_sound_data *data,
+				       enum pamir_ai_i2c_op op)
+{
+	KUNIT_EXPECT_EQ(test, data->stats[op].retries, 0);
+	KUNIT_EXPECT_EQ(test, data->stats[op].naks, 0);
+	KUNIT_EXPECT_EQ(test, data->stats[op].errors, 0);
+}
+
+static void pamir_ai_test_write_sequence(struct kunit *test)
+{
+	struct pamir_ai_test *priv = test->priv;
+	struct pamir_ai_i2c_sound_data *data = &priv->data;
+	static const struct reg_sequence seq[] = {
+		{ AIC3204_NDAC, 0x81 },
+		/* The delay ends the block after MDAC */
+		{ AIC3204_MDAC, 0x82, 10 },
+		{ AIC3204_DOSRMSB, 0x00 },
+		{ AIC3204_DOSRLSB, 0x80 },
+		/* Page 1, one block of four */
+		{ AIC3204_HPLGAIN, 0x00 },
+		{ AIC3204_REG(1, 0x11), 0x01 },
+		{ AIC3204_REG(1, 0x12), 0x02 },
+		{ AIC3204_LORGAIN, 0x03 },
+		/* Back on page 0, not adjacent to anything */
+		{ AIC3204_DACSETUP, 0xd4 },
+	};
+	unsigned int i;
+
+	KUNIT_ASSERT_EQ(test,
+			pamir_ai_i2c_sound_write_sequence(data, seq,
+							  ARRAY_SIZE(seq)),
+			0);
+
+	for (i = 0; i < ARRAY_SIZE(seq); i++)
+		KUNIT_EXPECT_EQ_MSG(test, priv->regs[seq[i].reg], seq[i].def,
+				    "page %u reg 0x%02x",
+				    AIC3204_REG_PAGE(seq[i].reg),
+				    AIC3204_REG_OFFSET(seq[i].reg));
+
+	pamir_ai_test_expect_clean(test, data, PAMIR_AI_OP_INIT);
+
+	/* NDAC-MDAC, DOSR, the four driver gains and DACSETUP */
+	KUNIT_EXPECT_EQ(test, data->stats[PAMIR_AI_OP_INIT].transactions, 4);
+	KUNIT_EXPECT_EQ(test, priv->regs_written, ARRAY_SIZE(seq));
+	/* To page 1 and back, the first page is read to seed the cache */
+	KUNIT_EXPECT_EQ(test, priv->page_selects, 2);
+	KUNIT_EXPECT_EQ(test, priv->bus_writes, 4 + 2);
+	KUNIT_EXPECT_LE(test, priv->bus_reads, 1);
+}
+
+static void pamir_ai_test_init_codec(struct kunit *test)
+{
+	struct pamir_ai_test *priv = test->priv;
+	struct pamir_ai_i2c_sound_data *data = &priv->data;
+
+	KUNIT_ASSERT_EQ(test, pamir_ai_i2c_sound_init_codec(data), 0);
+	pamir_ai_test_expect_clean(test, data, PAMIR_AI_OP_INIT);
+
+	/* 26 registers in 17 runs, one switch to page 1 and one back */
+	KUNIT_EXPECT_EQ(test, priv->regs_written, 26);
+	KUNIT_EXPECT_EQ(test, data->stats[PAMIR_AI_OP_INIT].transactions, 17);
+	KUNIT_EXPECT_EQ(test, priv->page_selects, 2);
+	KUNIT_EXPECT_LE(test, priv->bus_reads, 1);
+
+	/* First, last and page 1 entries of the sequence */
+	KUNIT_EXPECT_EQ(test, priv->regs[AIC3204_NDAC], 0x81);
+	KUNIT_EXPECT_EQ(test, priv->regs[AIC3204_HPLROUTE], 0x08);
+	KUNIT_EXPECT_EQ(test, priv->regs[AIC3204_LORROUTE], 0x08);
+	KUNIT_EXPECT_EQ(test, priv->regs[AIC3204_RMICPGAVOL], 0x0f);
+	KUNIT_EXPECT_EQ(test, priv->regs[AIC3204_RAGCMAXGAIN], 0x50);
+}
+
+static void pamir_ai_test_init_board(struct kunit *test)
+{
+	struct pamir_ai_test *priv = test->priv;
+	struct pamir_ai_i2c_sound_data *data = &priv->data;
+	static const u8 board[] = {
+		/* HP and LO drivers at 0 dB, one block */
+		1, 0x10, 0x00,
+		1, 0x11, 0x00,
+		1, 0x12, 0x00,
+		1, 0x13, 0x00,
+		/* Overrides the built-in DACSETUP */
+		0, 0x3f, 0xd4,
+	};
+	unsigned int val;
+
+	pamir_ai_test_set_board(test, priv, board, sizeof(board));
+
+	KUNIT_ASSERT_EQ(test, pamir_ai_i2c_sound_init_codec(data), 0);
+	KUNIT_ASSERT_EQ(test, pamir_ai_i2c_sound_init_board(data), 0);
+	pamir_ai_test_expect_clean(test, data, PAMIR_AI_OP_INIT);
+
+	KUNIT_EXPECT_EQ(test, data->stats[PAMIR_AI_OP_INIT].transactions,
+			17 + 2);
+	KUNIT_EXPECT_EQ(test, priv->regs_written, 26 + 5);
+	/* The built-in sequence ends on page 0, the board goes to 1 and back */
+	KUNIT_EXPECT_EQ(test, priv->page_selects, 2 + 2);
+
+	KUNIT_EXPECT_EQ(test, priv->regs[AIC3204_HPLGAIN], 0x00);
+	KUNIT_EXPECT_EQ(test, priv->regs[AIC3204_LORGAIN], 0x00);
+	KUNIT_EXPECT_EQ(test, priv->regs[AIC3204_DACSETUP], 0xd4);
+
+	/* The cache follows the board value, so resume restores it */
+	KUNIT_ASSERT_EQ(test, regmap_read(data->regmap, AIC3204_DACSETUP,
+					  &val), 0);
+	KUNIT_EXPECT_EQ(test, val, 0xd4);
+}
+
+/**
+ * struct pamir_ai_test_board - a pamir-ai,init-sequence to be refused
+ * @desc: what is wrong with @seq
+ * @seq: property value
+ * @len: length of @seq in bytes
+ */
+struct pamir_ai_test_board {
+	const char *desc;
+	u8 seq[6];
+	size_t len;
+};
+
+static const struct pamir_ai_test_board pamir_ai_test_bad_boards[] = {
+	{ "not triplets", { 1, 0x10, 0x00, 1, 0x11 }, 5 },
+	{ "page select", { 1, 0x10, 0x00, 0, 0x00, 0x01 }, 6 },
+	{ "volatile register", { 1, 0x10, 0x00, 0, 0x01, 0x01 }, 6 },
+	{ "register out of page", { 1, 0x10, 0x00, 1, 0x80, 0x00 }, 6 },
+};
+
+static void pamir_ai_test_bad_board_desc(const struct pamir_ai_test_board *b,
+					 char *desc)
+{
+	strscpy(desc, b->desc, KUNIT_PARAM_DESC_SIZE);
+}
+
+KUNIT_ARRAY_PARAM(pamir_ai_test_bad_board, pamir_ai_test_bad_boards,
+		  pamir_ai_test_bad_board_desc);
+
+static void pamir_ai_test_init_board_invalid(struct kunit *test)
+{
+	const struct pamir_ai_test_board *board = test->param_value;
+	struct pamir_ai_test *priv = test->priv;
+
+	pamir_ai_test_set_board(test, priv, board->seq, board->len);
+
+	KUNIT_EXPECT_EQ(test, pamir_ai_i2c_sound_init_board(&priv->data),
+			-EINVAL);
+	/* Refused as a whole, the valid first triplet is not written */
+	KUNIT_EXPECT_EQ(test, priv->bus_writes, 0);
+}
+
+static void pamir_ai_test_volume_round_trip(struct kunit *test)
+{
+	struct pamir_ai_test *priv = test->priv;
+	struct pamir_ai_i2c_sound_data *data = &priv->data;
+	int i, volume;
+
+	/* All the way up, then back down to cross every band both ways */
+	for (i = 0; i <= 200; i++) {
+		volume = i <= 100 ? i : 200 - i;
+
+		KUNIT_ASSERT_EQ(test,
+				pamir_ai_i2c_sound_set_volume(data, volume), 0);
+		KUNIT_EXPECT_EQ(test, priv->regs[AIC3204_LDACVOL],
+				priv->regs[AIC3204_RDACVOL]);
+		KUNIT_EXPECT_EQ(test, priv->regs[AIC3204_HPLGAIN],
+				priv->regs[AIC3204_LORGAIN]);
+
+		data->volume = U8_MAX;
+		KUNIT_ASSERT_EQ(test, pamir_ai_i2c_sound_get_volume(data), 0);
+		KUNIT_EXPECT_EQ_MSG(test, data->volume, volume,
+				    "hp 0x%02x dac 0x%02x",
+				    priv->regs[AIC3204_HPLGAIN],
+				    priv->regs[AIC3204_LDACVOL]);
+	}
+
+	pamir_ai_test_expect_clean(test, data, PAMIR_AI_OP_VOLUME_SET);
+	pamir_ai_test_expect_clean(test, data, PAMIR_AI_OP_VOLUME_GET);
+
+	/*
+	 * One DAC block per level and one driver gain block per band
+	 * crossing, at 1, 21 and 61 going up and 60, 20 and 0 going down.
+	 * Level 0 matches the muted power-on gain and writes no driver gain.
+	 */
+	KUNIT_EXPECT_EQ(test, data->stats[PAMIR_AI_OP_VOLUME_SET].transactions,
+			201 + 6);
+	/* The driver gains are on page 1, the DAC volumes on page 0 */
+	KUNIT_EXPECT_EQ(test, priv->page_selects, 2 * 6);
+	KUNIT_EXPECT_EQ(test, priv->bus_writes, 201 + 6 + 2 * 6);
+
+	/* The previous driver gain and all read backs come from the cache */
+	KUNIT_EXPECT_EQ(test, data->stats[PAMIR_AI_OP_VOLUME_GET].transactions,
+			0);
+	KUNIT_EXPECT_LE(test, priv->bus_reads, 1);
+}
+
+static void pamir_ai_test_gain_round_trip(struct kunit *test)
+{
+	struct pamir_ai_test *priv = test->priv;
+	struct pamir_ai_i2c_sound_data *data = &priv->data;
+	int gain;
+
+	for (gain = 0; gain <= 100; gain++) {
+		KUNIT_ASSERT_EQ(test,
+				pamir_ai_i2c_sound_set_input_gain(data, gain),
+				0);
+		KUNIT_EXPECT_EQ(test, priv->regs[AIC3204_LADCVOL],
+				priv->regs[AIC3204_RADCVOL]);
+
+		data->input_gain = U8_MAX;
+		KUNIT_ASSERT_EQ(test,
+				pamir_ai_i2c_sound_get_input_gain(data), 0);
+		KUNIT_EXPECT_EQ_MSG(test, data->input_gain, gain,
+				    "adc 0x%02x fine 0x%02x",
+				    priv->regs[AIC3204_LADCVOL],
+				    priv->regs[AIC3204_ADCFGA]);
+	}
+
+	pamir_ai_test_expect_clean(test, data, PAMIR_AI_OP_GAIN_SET);
+	pamir_ai_test_expect_clean(test, data, PAMIR_AI_OP_GAIN_GET);
+
+	/* One block write per level, read backs come from the cache */
+	KUNIT_EXPECT_EQ(test, data->stats[PAMIR_AI_OP_GAIN_SET].transactions,
+			101);
+	KUNIT_EXPECT_EQ(test, data->stats[PAMIR_AI_OP_GAIN_GET].transactions,
+			0);
+	KUNIT_EXPECT_EQ(test, priv->regs_written, 3 * 101);
+	/* Fine gain and both ADC volumes are all on page 0 */
+	KUNIT_EXPECT_EQ(test, priv->page_selects, 0);
+	KUNIT_EXPECT_LE(test, priv->bus_reads, 1);
+}
+
+/*
+ * The volume_level sweep from the README, timed the way i2c_stats
+ * reports it, on a bus as slow as the board's.
+ */
+static void pamir_ai_test_volume_latency(struct kunit *test)
+{
+	struct pamir_ai_test *priv = test->priv;
+	struct pamir_ai_i2c_sound_data *data = &priv->data;
+	struct pamir_ai_i2c_stats *stats;
+	ktime_t start;
+	s64 elapsed;
+	int volume;
+
+	priv->bus_hz = PAMIR_AI_TEST_BUS_HZ;
+
+	start = ktime_get();
+	for (volume = 0; volume <= 100; volume++)
+		KUNIT_ASSERT_EQ(test,
+				pamir_ai_i2c_sound_set_volume(data, volume), 0);
+	elapsed = ktime_us_delta(ktime_get(), start);
+
+	stats = &data->stats[PAMIR_AI_OP_VOLUME_SET];
+	KUNIT_EXPECT_EQ(test, stats->transactions, 101 + 3);
+	KUNIT_EXPECT_LE(test, pamir_ai_i2c_percentile(stats, 50),
+			PAMIR_AI_TEST_LEVEL_US);
+	KUNIT_EXPECT_LE(test, pamir_ai_i2c_percentile(stats, 99),
+			PAMIR_AI_TEST_CROSSING_US);
+	KUNIT_EXPECT_LE(test, elapsed,
+			101 * PAMIR_AI_TEST_LEVEL_US +
+			3 * PAMIR_AI_TEST_CROSSING_US);
+
+	kunit_info(test, "101 levels at %u Hz in %lld us, p50 %u us, p99 %u us\n",
+		   priv->bus_hz, elapsed, pamir_ai_i2c_percentile(stats, 50),
+		   pamir_ai_i2c_percentile(stats, 99));
+}
+
+static struct kunit_case pamir_ai_i2c_sound_test_cases[] = {
+	KUNIT_CASE(pamir_ai_test_write_sequence),
+	KUNIT_CASE(pamir_ai_test_init_codec),
+	KUNIT_CASE(pamir_ai_test_init_board),
+	KUNIT_CASE_PARAM(pamir_ai_test_init_board_invalid,
+			 pamir_ai_test_bad_board_gen_params),
+	KUNIT_CASE(pamir_ai_test_volume_round_trip),
+	KUNIT_CASE(pamir_ai_test_gain_round_trip),
+	KUNIT_CASE(pamir_ai_test_volume_latency),
+	{}
+};
+
+static struct kunit_suite pamir_ai_i2c_sound_test_suite = {
+	.name = "pamir-ai-i2c-sound",
+	.init = pamir_ai_test_init,
+	.test_cases = pamir_ai_i2c_sound_test_cases,
+};
+
+kunit_test_suite(pamir_ai_i2c_sound_test_suite);
+
+MODULE_AUTHOR("PamirAI, Inc");
+MODULE_DESCRIPTION("KUnit tests for the Pamir AI soundcard codec driver");
+MODULE_LICENSE("GPL v2");
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+MODULE_IMPORT_NS("EXPORTED_FOR_KUNIT_TESTING");
+#else
+MODULE_IMPORT_NS(EXPORTED_FOR_KUNIT_TESTING);
+#endif
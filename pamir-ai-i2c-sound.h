@@ -0,0 +1,191 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Private data of the Pamir AI soundcard codec driver, shared with its
+ * KUnit tests.
+ *
+ * Copyright (C) 2025 PamirAI Incorporated - http://www.pamir.ai/
+ */
+
+#ifndef _PAMIR_AI_I2C_SOUND_H
+#define _PAMIR_AI_I2C_SOUND_H
+
+#include <linux/completion.h>
+#include <linux/mutex.h>
+#include <linux/regmap.h>
+#include <linux/spinlock.h>
+#include <linux/types.h>
+#include <linux/workqueue.h>
+#include <sound/pcm.h>
+#include <sound/soc.h>
+
+#include "pamir-ai-aic3204.h"
+
+/*
+ * Register access latency histogram: bucket 0 counts accesses below
+ * 1 us, bucket n those of 2^(n-1) to 2^n us and the last bucket
+ * everything slower.
+ */
+#define PAMIR_AI_LAT_BUCKETS		20
+
+struct pamir_ai_clk_div;
+
+/**
+ * enum pamir_ai_i2c_op - driver operations accounted in the I2C statistics
+ * @PAMIR_AI_OP_INIT: initialization sequence written at probe
+ * @PAMIR_AI_OP_VOLUME_SET: volume_level writes and ramp steps
+ * @PAMIR_AI_OP_VOLUME_GET: volume_level reads
+ * @PAMIR_AI_OP_GAIN_SET: input_gain writes
+ * @PAMIR_AI_OP_GAIN_GET: input_gain reads
+ * @PAMIR_AI_OP_REG_ACCESS: register_access and register_pages
+ * @PAMIR_AI_OP_CLOCKS: clock tree and audio interface programming
+ * @PAMIR_AI_OP_DSP: coefficient RAM writes and buffer switches
+ * @PAMIR_AI_OP_COUNT: number of operation types
+ */
+enum pamir_ai_i2c_op {
+	PAMIR_AI_OP_INIT,
+	PAMIR_AI_OP_VOLUME_SET,
+	PAMIR_AI_OP_VOLUME_GET,
+	PAMIR_AI_OP_GAIN_SET,
+	PAMIR_AI_OP_GAIN_GET,
+	PAMIR_AI_OP_REG_ACCESS,
+	PAMIR_AI_OP_CLOCKS,
+	PAMIR_AI_OP_DSP,
+	PAMIR_AI_OP_COUNT,
+};
+
+/**
+ * struct pamir_ai_i2c_stats - register access statistics of one operation
+ * @transactions: register or block accesses issued
+ * @retries: accesses repeated after a transient bus error
+ * @naks: attempts the codec did not acknowledge
+ * @errors: attempts that failed for any other reason
+ * @hist: access duration histogram, see PAMIR_AI_LAT_BUCKETS
+ */
+struct pamir_ai_i2c_stats {
+	u64 transactions;
+	u64 retries;
+	u64 naks;
+	u64 errors;
+	u32 hist[PAMIR_AI_LAT_BUCKETS];
+};
+
+/**
+ * struct pamir_ai_i2c_sound_data - private data for pamir AI sound
+ * @client: I2C client
+ * @dev: device structure
+ * @regmap: paged register map of the codec
+ * @mclk: optional codec MCLK input, gated while runtime suspended
+ * @reset_gpio: optional active-low RESET line of the codec
+ * @in_reset: @reset_gpio was asserted when the codec went idle
+ * @mclk_rate: frequency of the codec MCLK input
+ * @rates: sample rates the clock table can generate from @mclk_rate
+ * @rate_constraint: constraint list over @rates applied at startup
+ * @bclk_ratio: BCLK cycles per frame set by the machine driver, 0 if
+ *	it follows the sample width
+ * @fmt_offset: data offset in BCLKs required by the DAI format
+ * @tdm_slots: slots per frame in TDM mode, 0 for plain two-slot frames
+ * @tdm_width: TDM slot width in bits
+ * @tdm_offset: BCLKs from the start of the frame to the codec's first slot
+ * @clk_div: clock tree settings currently programmed, NULL if unknown
+ * @low_latency: use the minimum-delay processing blocks from the next
+ *	hw_params on
+ * @clk_low_latency: value of @low_latency when @clk_div was programmed
+ * @dosr: DAC oversampling ratio programmed along with @clk_div
+ * @clk_provider: the codec generates BCLK and WCLK on the link
+ * @dac_delay: group delay of the programmed DAC path in frames
+ * @adc_delay: group delay of the programmed ADC path in frames
+ * @volume: volume level (0-100)
+ * @input_gain: input gain level (0-100)
+ * @level_lock: serialises the multi-register volume and input gain
+ *	sequences and protects @volume and @input_gain
+ * @update_work: deferred work applying the requested volume/gain
+ * @target_lock: protects @target_volume, @target_input_gain,
+ *	@ramp_ms and @ramp_end
+ * @target_volume: latest volume level requested from userspace
+ * @target_input_gain: latest input gain level requested from userspace
+ * @ramp_ms: time taken to move from the current to the target volume
+ * @ramp_end: jiffies at which the current volume ramp must complete
+ * @access_reg: register selected for reading through register_access
+ * @dsp_profiles: "Flat" followed by the "pamir-ai,dsp-profiles" names
+ * @dsp_enum: enum backing the "DSP Profile" control
+ * @dsp_profile: index in @dsp_profiles of the coefficient set in use
+ * @dsp_lock: protects @dsp_profile, @coefs and the coefficient RAM
+ * @coef_defaults: power-on contents of coefficient buffer A, per path
+ * @coefs: coefficient set in use, per path, restored after a reset
+ * @dsp_work: reads @coef_defaults once the component is registered
+ * @dsp_ready: completed once @dsp_work is done
+ * @dsp_err: result of @dsp_work
+ * @jack: jack reported through the codec's headset detection, if any
+ * @jack_lock: protects @jack
+ * @settle_timeout_ms: longest wait for an output driver to settle
+ * @stats: register access statistics, per operation type
+ * @stats_lock: protects @stats
+ * @debugfs: debugfs directory of the device
+ */
+struct pamir_ai_i2c_sound_data {
+	struct i2c_client *client;
+	struct device *dev;
+	struct regmap *regmap;
+	struct clk *mclk;
+	struct gpio_desc *reset_gpio;
+	bool in_reset;
+	unsigned long mclk_rate;
+	unsigned int *rates;
+	struct snd_pcm_hw_constraint_list rate_constraint;
+	unsigned int bclk_ratio;
+	u8 fmt_offset;
+	u8 tdm_slots;
+	u8 tdm_width;
+	u8 tdm_offset;
+	const struct pamir_ai_clk_div *clk_div;
+	bool low_latency;
+	bool clk_low_latency;
+	u16 dosr;
+	bool clk_provider;
+	u8 dac_delay;
+	u8 adc_delay;
+	u8 volume;
+	u8 input_gain;
+	struct mutex level_lock;
+	struct delayed_work update_work;
+	struct mutex target_lock;
+	u8 target_volume;
+	u8 target_input_gain;
+	unsigned int ramp_ms;
+	unsigned long ramp_end;
+	unsigned int access_reg;
+	const char **dsp_profiles;
+	struct soc_enum dsp_enum;
+	unsigned int dsp_profile;
+	struct mutex dsp_lock;
+	u8 (*coef_defaults)[AIC3204_COEF_PAGES][AIC3204_COEF_LEN];
+	u8 (*coefs)[AIC3204_COEF_PAGES][AIC3204_COEF_LEN];
+	struct work_struct dsp_work;
+	struct completion dsp_ready;
+	int dsp_err;
+	struct snd_soc_jack *jack;
+	struct mutex jack_lock;
+	unsigned int settle_timeout_ms;
+	struct pamir_ai_i2c_stats stats[PAMIR_AI_OP_COUNT];
+	spinlock_t stats_lock;
+	struct dentry *debugfs;
+};
+
+#if IS_ENABLED(CONFIG_KUNIT)
+int pamir_ai_i2c_sound_set_volume(struct pamir_ai_i2c_sound_data *data,
+				  u8 volume);
+int pamir_ai_i2c_sound_get_volume(struct pamir_ai_i2c_sound_data *data);
+int pamir_ai_i2c_sound_set_input_gain(struct pamir_ai_i2c_sound_data *data,
+				      u8 gain);
+int pamir_ai_i2c_sound_get_input_gain(struct pamir_ai_i2c_sound_data *data);
+int pamir_ai_i2c_sound_write_sequence(struct pamir_ai_i2c_sound_data *data,
+				      const struct reg_sequence *seq, int num);
+int pamir_ai_i2c_sound_init_codec(struct pamir_ai_i2c_sound_data *data);
+int pamir_ai_i2c_sound_init_board(struct pamir_ai_i2c_sound_data *data);
+unsigned int pamir_ai_i2c_percentile(const struct pamir_ai_i2c_stats *stats,
+				     unsigned int pct);
+
+extern const struct regmap_config pamir_ai_i2c_sound_regmap_config;
+#endif
+
+#endif /* _PAMIR_AI_I2C_SOUND_H */
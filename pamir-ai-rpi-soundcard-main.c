@@ -16,27 +16,80 @@
  * General Public License for more details.
  */
 
+#include <linux/device.h>
+#include <linux/i2c.h>
 #include <linux/module.h>
+#include <linux/of.h>
+#include <linux/of_device.h>
+#include <linux/of_platform.h>
 #include <linux/platform_device.h>
 #include <linux/gpio/consumer.h>
 
 #include <sound/core.h>
+#include <sound/jack.h>
 #include <sound/pcm.h>
 #include <sound/pcm_params.h>
 #include <sound/soc.h>
 
-/* Parameters for Pamir AI RPI soundcard */
+/*
+ * Period sizes are kept a multiple of this, so that every period starts
+ * on a DMA burst and cache line boundary
+ */
+#define PAMIR_AI_DMA_ALIGN_BYTES	32
+
+/*
+ * Parameters for Pamir AI RPI soundcard, allocated per device so that
+ * several cards (one per I2S controller and codec) can coexist
+ */
 struct snd_pamir_ai_simple_drvdata {
-	struct snd_soc_dai_link *dai;
-	const char* card_name;
+	struct snd_soc_card card;
+	struct snd_soc_dai_link dai;
+	struct snd_soc_dai_link_component cpu;
+	struct snd_soc_dai_link_component codec;
+	struct snd_soc_dai_link_component platform;
 	unsigned int fixed_bclk_ratio;
+	/* The codec drives BCLK/WCLK from its PLL instead of the I2S block */
+	bool codec_clk_provider;
+	/* TDM frame layout, tdm_slots is 0 for plain I2S */
+	unsigned int tdm_slots;
+	unsigned int tdm_width;
+	unsigned int tdm_tx_mask;
+	unsigned int tdm_rx_mask;
+	unsigned int codec_tdm_slot;
+	/* Headset detection through the codec's interrupt */
+	bool jack_detect;
+	struct snd_soc_jack jack;
+	/* The jack links its pins into a list, so each card needs a copy */
+	struct snd_soc_jack_pin jack_pins[2];
+	/* Optional PCM constraints, a zero maximum leaves them unset */
+	u32 period_bytes[2];
+	u32 periods[2];
+	u32 buffer_bytes_max;
+};
+
+static const struct snd_soc_dapm_widget snd_pamir_ai_simple_widgets[] = {
+	SND_SOC_DAPM_HP("Headphone", NULL),
+	SND_SOC_DAPM_LINE("Line Out", NULL),
 };
 
-static struct snd_soc_card snd_pamir_ai_simple = {
-	.driver_name  = "PamirAI-simple",
-	.owner        = THIS_MODULE,
-	.dai_link     = NULL,
-	.num_links    = 1, /* Only a single DAI supported at the moment */
+static const struct snd_soc_dapm_route snd_pamir_ai_simple_routes[] = {
+	{ "Headphone", NULL, "HPL" },
+	{ "Headphone", NULL, "HPR" },
+	{ "Line Out", NULL, "LOL" },
+	{ "Line Out", NULL, "LOR" },
+};
+
+/* Plugging headphones in moves playback from the line out to them */
+static const struct snd_soc_jack_pin snd_pamir_ai_simple_jack_pins[] = {
+	{
+		.pin = "Headphone",
+		.mask = SND_JACK_HEADPHONE,
+	},
+	{
+		.pin = "Line Out",
+		.mask = SND_JACK_HEADPHONE,
+		.invert = 1,
+	},
 };
 
 static int snd_pamir_ai_simple_init(struct snd_soc_pcm_runtime *rtd)
@@ -44,10 +97,51 @@ static int snd_pamir_ai_simple_init(struct snd_soc_pcm_runtime *rtd)
 	struct snd_pamir_ai_simple_drvdata *drvdata =
 		snd_soc_card_get_drvdata(rtd->card);
 	struct snd_soc_dai *cpu_dai = snd_soc_rtd_to_cpu(rtd, 0);
+	struct snd_soc_dai *codec_dai = snd_soc_rtd_to_codec(rtd, 0);
+	int ret;
+
+	if (drvdata->jack_detect) {
+		ret = snd_soc_card_jack_new_pins(rtd->card, "Headset Jack",
+				SND_JACK_HEADSET, &drvdata->jack,
+				drvdata->jack_pins,
+				ARRAY_SIZE(drvdata->jack_pins));
+		if (ret)
+			return ret;
+
+		ret = snd_soc_component_set_jack(codec_dai->component,
+				&drvdata->jack, NULL);
+		if (ret)
+			return ret;
+	}
+
+	if (drvdata->tdm_slots) {
+		ret = snd_soc_dai_set_tdm_slot(cpu_dai, drvdata->tdm_tx_mask,
+				drvdata->tdm_rx_mask, drvdata->tdm_slots,
+				drvdata->tdm_width);
+		if (ret)
+			return ret;
+
+		/* The codec's stereo pair sits in two adjacent slots */
+		return snd_soc_dai_set_tdm_slot(codec_dai,
+				0x3 << drvdata->codec_tdm_slot,
+				0x3 << drvdata->codec_tdm_slot,
+				drvdata->tdm_slots, drvdata->tdm_width);
+	}
+
+	/* As clock provider the codec derives BCLK from the frame itself */
+	if (drvdata->codec_clk_provider)
+		return 0;
+
+	if (drvdata->fixed_bclk_ratio > 0) {
+		ret = snd_soc_dai_set_bclk_ratio(cpu_dai,
+				drvdata->fixed_bclk_ratio);
+		if (ret)
+			return ret;
 
-	if (drvdata->fixed_bclk_ratio > 0)
-		return snd_soc_dai_set_bclk_ratio(cpu_dai,
+		/* Lets the codec refuse sample widths the frame can't hold */
+		return snd_soc_dai_set_bclk_ratio(codec_dai,
 				drvdata->fixed_bclk_ratio);
+	}
 
 	return 0;
 }
@@ -62,8 +156,9 @@ static int snd_pamir_ai_simple_hw_params(struct snd_pcm_substream *substream,
 
 	drvdata = snd_soc_card_get_drvdata(rtd->card);
 
-	if (drvdata->fixed_bclk_ratio > 0)
-		return 0; // BCLK is configured in .init
+	if (drvdata->tdm_slots || drvdata->fixed_bclk_ratio > 0 ||
+	    drvdata->codec_clk_provider)
+		return 0; // BCLK is configured in .init or by the codec
 
 	/* The simple drivers just set the bclk_ratio to sample_bits * 2 so
 	 * hard-code this for now, but sticking to powers of 2 to allow for
@@ -76,75 +171,318 @@ static int snd_pamir_ai_simple_hw_params(struct snd_pcm_substream *substream,
 	return snd_soc_dai_set_bclk_ratio(cpu_dai, sample_bits * 2);
 }
 
-static struct snd_soc_ops snd_pamir_ai_simple_ops = {
+/*
+ * Applies the DT period and buffer limits on top of what the I2S DMA
+ * allows. Whole periods only, so the DMA never wraps mid-period.
+ */
+static int snd_pamir_ai_simple_startup(struct snd_pcm_substream *substream)
+{
+	struct snd_soc_pcm_runtime *rtd = substream->private_data;
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	struct snd_pamir_ai_simple_drvdata *drvdata;
+	int ret;
+
+	drvdata = snd_soc_card_get_drvdata(rtd->card);
+
+	ret = snd_pcm_hw_constraint_integer(runtime,
+			SNDRV_PCM_HW_PARAM_PERIODS);
+	if (ret < 0)
+		return ret;
+
+	ret = snd_pcm_hw_constraint_step(runtime, 0,
+			SNDRV_PCM_HW_PARAM_PERIOD_BYTES,
+			PAMIR_AI_DMA_ALIGN_BYTES);
+	if (ret < 0)
+		return ret;
+
+	if (drvdata->period_bytes[1]) {
+		ret = snd_pcm_hw_constraint_minmax(runtime,
+				SNDRV_PCM_HW_PARAM_PERIOD_BYTES,
+				drvdata->period_bytes[0],
+				drvdata->period_bytes[1]);
+		if (ret < 0)
+			return ret;
+	}
+
+	if (drvdata->periods[1]) {
+		ret = snd_pcm_hw_constraint_minmax(runtime,
+				SNDRV_PCM_HW_PARAM_PERIODS,
+				drvdata->periods[0], drvdata->periods[1]);
+		if (ret < 0)
+			return ret;
+	}
+
+	if (drvdata->buffer_bytes_max) {
+		ret = snd_pcm_hw_constraint_minmax(runtime,
+				SNDRV_PCM_HW_PARAM_BUFFER_BYTES, 0,
+				drvdata->buffer_bytes_max);
+		if (ret < 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+static const struct snd_soc_ops snd_pamir_ai_simple_ops = {
+	.startup = snd_pamir_ai_simple_startup,
 	.hw_params = snd_pamir_ai_simple_hw_params,
 };
 
-SND_SOC_DAILINK_DEFS(pamir_ai,
-	DAILINK_COMP_ARRAY(COMP_EMPTY()),
-	DAILINK_COMP_ARRAY(COMP_CODEC("pamir-ai-soundcard", "pamir-ai-hifi")),
-	DAILINK_COMP_ARRAY(COMP_EMPTY()));
-
-static struct snd_soc_dai_link snd_pamir_ai_soundcard_dai[] = {
-{
+/* Template of the card's DAI link, the components are filled in at probe */
+static const struct snd_soc_dai_link snd_pamir_ai_soundcard_dai = {
 	.name           = "Pamir AI SoundCard",
 	.stream_name    = "Pamir AI SoundCard HiFi",
 	.dai_fmt        =  SND_SOC_DAIFMT_I2S | SND_SOC_DAIFMT_NB_NF |
-				SND_SOC_DAIFMT_CBS_CFS,
-	SND_SOC_DAILINK_REG(pamir_ai),
-},
-};
-
-static struct snd_pamir_ai_simple_drvdata drvdata_pamir_ai = {
-	.card_name = "snd_pamir_ai_soundcard",
-	.dai       = snd_pamir_ai_soundcard_dai,
+				SND_SOC_DAIFMT_CBC_CFC,
+	.init           = snd_pamir_ai_simple_init,
+	.ops            = &snd_pamir_ai_simple_ops,
 };
 
 static const struct of_device_id snd_pamir_ai_simple_of_match[] = {
 	{ .compatible = "pamir-ai,rpi-soundcard",
-		.data = (void *) &drvdata_pamir_ai },
+		.data = &snd_pamir_ai_soundcard_dai },
 	{},
 };
 
-static int snd_pamir_ai_simple_probe(struct platform_device *pdev)
+/*
+ * Optional TDM layout from the standard dai-tdm-slot-* properties. The
+ * tx/rx masks describe the slots carried by the I2S controller, and
+ * pamir-ai,codec-tdm-slot the first of the two slots used by the codec.
+ */
+static int snd_pamir_ai_simple_parse_tdm(struct device *dev,
+		struct snd_pamir_ai_simple_drvdata *drvdata)
 {
-	int ret = 0;
-	const struct of_device_id *of_id;
+	struct snd_soc_dai_link *dai = &drvdata->dai;
+	int ret;
 
-	snd_pamir_ai_simple.dev = &pdev->dev;
-	of_id = of_match_node(snd_pamir_ai_simple_of_match, pdev->dev.of_node);
+	drvdata->tdm_slots = 0;
+	drvdata->tdm_width = 32;
+	drvdata->codec_tdm_slot = 0;
+	ret = snd_soc_of_parse_tdm_slot(dev->of_node, &drvdata->tdm_tx_mask,
+			&drvdata->tdm_rx_mask, &drvdata->tdm_slots,
+			&drvdata->tdm_width);
+	if (ret) {
+		dev_err(dev, "Failed to parse TDM slots: %d\n", ret);
+		return ret;
+	}
 
-	if (pdev->dev.of_node && of_id->data) {
-		struct device_node *i2s_node;
-		struct snd_pamir_ai_simple_drvdata *drvdata =
-			(struct snd_pamir_ai_simple_drvdata *) of_id->data;
-		struct snd_soc_dai_link *dai = drvdata->dai;
+	if (!drvdata->tdm_slots)
+		return 0;
 
-		snd_soc_card_set_drvdata(&snd_pamir_ai_simple, drvdata);
+	if (drvdata->tdm_slots < 2 || drvdata->tdm_slots > 32) {
+		dev_err(dev, "Invalid TDM slot count %u\n",
+				drvdata->tdm_slots);
+		return -EINVAL;
+	}
 
-		/* More complex drivers might override individual functions */
-		if (!dai->init)
-			dai->init = snd_pamir_ai_simple_init;
-		if (!dai->ops)
-			dai->ops = &snd_pamir_ai_simple_ops;
+	of_property_read_u32(dev->of_node, "pamir-ai,codec-tdm-slot",
+			&drvdata->codec_tdm_slot);
+	if (drvdata->codec_tdm_slot + 2 > drvdata->tdm_slots) {
+		dev_err(dev, "Codec TDM slot %u out of range\n",
+				drvdata->codec_tdm_slot);
+		return -EINVAL;
+	}
 
-		snd_pamir_ai_simple.name = drvdata->card_name;
+	/* Default to carrying every slot of the frame */
+	if (!drvdata->tdm_tx_mask)
+		drvdata->tdm_tx_mask = GENMASK(drvdata->tdm_slots - 1, 0);
+	if (!drvdata->tdm_rx_mask)
+		drvdata->tdm_rx_mask = GENMASK(drvdata->tdm_slots - 1, 0);
 
-		snd_pamir_ai_simple.dai_link = dai;
-		i2s_node = of_parse_phandle(pdev->dev.of_node,
-				"i2s-controller", 0);
-		if (!i2s_node) {
-			pr_err("Failed to find i2s-controller DT node\n");
-			return -ENODEV;
-		}
+	/* TDM frames start on a single-cycle frame sync */
+	dai->dai_fmt = (dai->dai_fmt & ~SND_SOC_DAIFMT_FORMAT_MASK) |
+			SND_SOC_DAIFMT_DSP_A;
+	return 0;
+}
 
-		dai->cpus->of_node = i2s_node;
-		dai->platforms->of_node = i2s_node;
+/*
+ * Optional PCM limits: pamir-ai,period-bytes and pamir-ai,periods are
+ * <min max> pairs, pamir-ai,buffer-bytes-max a single value.
+ */
+static int snd_pamir_ai_simple_parse_pcm(struct device *dev,
+		struct snd_pamir_ai_simple_drvdata *drvdata)
+{
+	struct device_node *np = dev->of_node;
+
+	of_property_read_u32_array(np, "pamir-ai,period-bytes",
+			drvdata->period_bytes, 2);
+	of_property_read_u32_array(np, "pamir-ai,periods",
+			drvdata->periods, 2);
+	of_property_read_u32(np, "pamir-ai,buffer-bytes-max",
+			&drvdata->buffer_bytes_max);
+
+	if (drvdata->period_bytes[0] > drvdata->period_bytes[1] ||
+	    drvdata->period_bytes[0] % PAMIR_AI_DMA_ALIGN_BYTES ||
+	    drvdata->period_bytes[1] % PAMIR_AI_DMA_ALIGN_BYTES) {
+		dev_err(dev, "Invalid period size %u-%u bytes, must be a multiple of %u\n",
+				drvdata->period_bytes[0],
+				drvdata->period_bytes[1],
+				PAMIR_AI_DMA_ALIGN_BYTES);
+		return -EINVAL;
 	}
 
-	ret = devm_snd_soc_register_card(&pdev->dev, &snd_pamir_ai_simple);
+	if (drvdata->periods[0] > drvdata->periods[1]) {
+		dev_err(dev, "Invalid period count %u-%u\n",
+				drvdata->periods[0], drvdata->periods[1]);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void snd_pamir_ai_simple_put_node(void *node)
+{
+	of_node_put(node);
+}
+
+/* Looks up a phandle, dropping the node reference with the card */
+static struct device_node *snd_pamir_ai_simple_get_node(struct device *dev,
+		const char *prop)
+{
+	struct device_node *node;
+
+	node = of_parse_phandle(dev->of_node, prop, 0);
+	if (!node) {
+		dev_err(dev, "Failed to find %s DT node\n", prop);
+		return NULL;
+	}
+
+	if (devm_add_action_or_reset(dev, snd_pamir_ai_simple_put_node, node))
+		return NULL;
+
+	return node;
+}
+
+/*
+ * The i2s-controller and pamir-ai,codec phandles are not known to
+ * fw_devlink, so the card is tied to both devices explicitly. While one
+ * of them is unbound the card defers once and is probed again by the
+ * driver core as soon as it binds, instead of on every deferred probe
+ * pass.
+ */
+static int snd_pamir_ai_simple_link(struct device *dev,
+		struct device *supplier)
+{
+	int ret = 0;
+
+	if (!device_link_add(dev, supplier, DL_FLAG_AUTOPROBE_CONSUMER)) {
+		dev_err(dev, "Failed to link to %s\n", dev_name(supplier));
+		ret = -EINVAL;
+	} else if (!device_is_bound(supplier)) {
+		ret = -EPROBE_DEFER;
+	}
+
+	put_device(supplier);
+	return ret;
+}
+
+static int snd_pamir_ai_simple_link_suppliers(struct device *dev,
+		struct device_node *i2s_node, struct device_node *codec_node)
+{
+	struct platform_device *i2s;
+	struct i2c_client *codec;
+	int ret;
+
+	/* Not even created yet, the bus or the overlay is still coming up */
+	i2s = of_find_device_by_node(i2s_node);
+	if (!i2s)
+		return -EPROBE_DEFER;
+
+	ret = snd_pamir_ai_simple_link(dev, &i2s->dev);
+	if (ret)
+		return ret;
+
+	codec = of_find_i2c_device_by_node(codec_node);
+	if (!codec)
+		return -EPROBE_DEFER;
+
+	return snd_pamir_ai_simple_link(dev, &codec->dev);
+}
+
+static int snd_pamir_ai_simple_probe(struct platform_device *pdev)
+{
+	struct device *dev = &pdev->dev;
+	const struct snd_soc_dai_link *template;
+	struct snd_pamir_ai_simple_drvdata *drvdata;
+	struct device_node *i2s_node, *codec_node;
+	struct snd_soc_dai_link *dai;
+	struct snd_soc_card *card;
+	int ret;
+
+	template = of_device_get_match_data(dev);
+	if (!template)
+		return -ENODEV;
+
+	drvdata = devm_kzalloc(dev, sizeof(*drvdata), GFP_KERNEL);
+	if (!drvdata)
+		return -ENOMEM;
+
+	dai = &drvdata->dai;
+	*dai = *template;
+	memcpy(drvdata->jack_pins, snd_pamir_ai_simple_jack_pins,
+	       sizeof(drvdata->jack_pins));
+
+	i2s_node = snd_pamir_ai_simple_get_node(dev, "i2s-controller");
+	if (!i2s_node)
+		return -ENODEV;
+
+	codec_node = snd_pamir_ai_simple_get_node(dev, "pamir-ai,codec");
+	if (!codec_node)
+		return -ENODEV;
+
+	ret = snd_pamir_ai_simple_link_suppliers(dev, i2s_node, codec_node);
+	if (ret)
+		return ret;
+
+	drvdata->cpu.of_node = i2s_node;
+	drvdata->platform.of_node = i2s_node;
+	drvdata->codec.of_node = codec_node;
+	drvdata->codec.dai_name = "pamir-ai-hifi";
+	dai->cpus = &drvdata->cpu;
+	dai->num_cpus = 1;
+	dai->codecs = &drvdata->codec;
+	dai->num_codecs = 1;
+	dai->platforms = &drvdata->platform;
+	dai->num_platforms = 1;
+
+	/* The codec can only detect a headset with its INT1 wired up */
+	drvdata->jack_detect = of_property_present(codec_node, "interrupts");
+
+	ret = snd_pamir_ai_simple_parse_tdm(dev, drvdata);
+	if (ret)
+		return ret;
+
+	ret = snd_pamir_ai_simple_parse_pcm(dev, drvdata);
+	if (ret)
+		return ret;
+
+	drvdata->codec_clk_provider = of_property_read_bool(dev->of_node,
+			"pamir-ai,codec-clock-provider");
+	dai->dai_fmt &= ~SND_SOC_DAIFMT_CLOCK_PROVIDER_MASK;
+	dai->dai_fmt |= drvdata->codec_clk_provider ?
+			SND_SOC_DAIFMT_CBP_CFP : SND_SOC_DAIFMT_CBC_CFC;
+
+	card = &drvdata->card;
+	card->dev = dev;
+	card->owner = THIS_MODULE;
+	card->driver_name = "PamirAI-simple";
+	card->name = "snd_pamir_ai_soundcard";
+	card->dai_link = dai;
+	card->num_links = 1;
+	card->dapm_widgets = snd_pamir_ai_simple_widgets;
+	card->num_dapm_widgets = ARRAY_SIZE(snd_pamir_ai_simple_widgets);
+	card->dapm_routes = snd_pamir_ai_simple_routes;
+	card->num_dapm_routes = ARRAY_SIZE(snd_pamir_ai_simple_routes);
+	snd_soc_card_set_drvdata(card, drvdata);
+
+	/* An optional label tells the cards of a multi-zone unit apart */
+	ret = snd_soc_of_parse_card_name(card, "label");
+	if (ret)
+		return ret;
+
+	ret = devm_snd_soc_register_card(dev, card);
 	if (ret && ret != -EPROBE_DEFER)
-		dev_err(&pdev->dev, "Failed to register card %d\n", ret);
+		dev_err(dev, "Failed to register card %d\n", ret);
 
 	return ret;
 }
@@ -154,6 +492,7 @@ static struct platform_driver snd_pamir_ai_simple_driver = {
 		.name   = "snd-pamir-ai-simple",
 		.owner  = THIS_MODULE,
 		.of_match_table = snd_pamir_ai_simple_of_match,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe          = snd_pamir_ai_simple_probe,
 };
@@ -0,0 +1,120 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Tracepoints for the Pamir AI soundcard codec driver.
+ *
+ * Copyright (C) 2025 PamirAI Incorporated - http://www.pamir.ai/
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM pamir_ai
+
+#if !defined(_PAMIR_AI_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _PAMIR_AI_TRACE_H
+
+#include <linux/i2c.h>
+#include <linux/tracepoint.h>
+
+#include "pamir-ai-aic3204.h"
+
+/*
+ * Every event records the codec's I2C adapter and address, printed like
+ * the client's device name, so several codecs can be told apart.
+ */
+TRACE_EVENT(pamir_ai_trigger,
+	TP_PROTO(struct i2c_client *client, int stream, int cmd),
+	TP_ARGS(client, stream, cmd),
+	TP_STRUCT__entry(
+		__field(int, adapter)
+		__field(u16, addr)
+		__field(int, stream)
+		__field(int, cmd)
+	),
+	TP_fast_assign(
+		__entry->adapter = i2c_adapter_id(client->adapter);
+		__entry->addr = client->addr;
+		__entry->stream = stream;
+		__entry->cmd = cmd;
+	),
+	TP_printk("%d-%04x %s cmd=%d", __entry->adapter, __entry->addr,
+		  __entry->stream ? "capture" : "playback", __entry->cmd)
+);
+
+TRACE_EVENT(pamir_ai_reg_write,
+	TP_PROTO(struct i2c_client *client, unsigned int reg, u8 val, int len,
+		 u64 latency_ns),
+	TP_ARGS(client, reg, val, len, latency_ns),
+	TP_STRUCT__entry(
+		__field(int, adapter)
+		__field(u16, addr)
+		__field(unsigned int, reg)
+		__field(u8, val)
+		__field(int, len)
+		__field(u64, latency_ns)
+	),
+	TP_fast_assign(
+		__entry->adapter = i2c_adapter_id(client->adapter);
+		__entry->addr = client->addr;
+		__entry->reg = reg;
+		__entry->val = val;
+		__entry->len = len;
+		__entry->latency_ns = latency_ns;
+	),
+	TP_printk("%d-%04x page=%u reg=0x%02x val=0x%02x len=%d latency=%lluns",
+		  __entry->adapter, __entry->addr,
+		  AIC3204_REG_PAGE(__entry->reg),
+		  AIC3204_REG_OFFSET(__entry->reg), __entry->val, __entry->len,
+		  __entry->latency_ns)
+);
+
+TRACE_EVENT(pamir_ai_volume,
+	TP_PROTO(struct i2c_client *client, u8 volume, u8 hp_val, u8 dac_val),
+	TP_ARGS(client, volume, hp_val, dac_val),
+	TP_STRUCT__entry(
+		__field(int, adapter)
+		__field(u16, addr)
+		__field(u8, volume)
+		__field(u8, hp_val)
+		__field(u8, dac_val)
+	),
+	TP_fast_assign(
+		__entry->adapter = i2c_adapter_id(client->adapter);
+		__entry->addr = client->addr;
+		__entry->volume = volume;
+		__entry->hp_val = hp_val;
+		__entry->dac_val = dac_val;
+	),
+	TP_printk("%d-%04x volume=%u%% hp_val=0x%02x dac_val=0x%02x",
+		  __entry->adapter, __entry->addr, __entry->volume,
+		  __entry->hp_val, __entry->dac_val)
+);
+
+TRACE_EVENT(pamir_ai_input_gain,
+	TP_PROTO(struct i2c_client *client, u8 gain, u8 adc_val, u8 fine_val),
+	TP_ARGS(client, gain, adc_val, fine_val),
+	TP_STRUCT__entry(
+		__field(int, adapter)
+		__field(u16, addr)
+		__field(u8, gain)
+		__field(u8, adc_val)
+		__field(u8, fine_val)
+	),
+	TP_fast_assign(
+		__entry->adapter = i2c_adapter_id(client->adapter);
+		__entry->addr = client->addr;
+		__entry->gain = gain;
+		__entry->adc_val = adc_val;
+		__entry->fine_val = fine_val;
+	),
+	TP_printk("%d-%04x gain=%u%% adc_val=0x%02x fine_val=0x%02x",
+		  __entry->adapter, __entry->addr, __entry->gain,
+		  __entry->adc_val, __entry->fine_val)
+);
+
+#endif /* _PAMIR_AI_TRACE_H */
+
+/* Out-of-tree build: the Makefile adds this directory to the include path */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE pamir-ai-trace
+#include <trace/define_trace.h>